@@ -0,0 +1,174 @@
+/**
+ * \file            cpp_example.cpp
+ * \brief           C++ front end example
+ *
+ * Same machine as `hierarchical_example.c`, with states as types.
+ * Requires C++17.
+ */
+
+#include "hsm.hpp"
+#include <stdio.h>
+
+/* Events */
+enum : hsm_event_t {
+    EVT_BUTTON_PRESS = HSM_EVENT_USER,
+    EVT_TIMEOUT,
+    EVT_MODE_CHANGE,
+    EVT_COMMON_ACTION,
+};
+
+/* Hierarchy:
+ * System (root)
+ *   ├── Active
+ *   │   ├── Mode1
+ *   │   └── Mode2
+ *   └── Standby
+ */
+struct Device;
+
+struct System : hsmpp::state<> {
+    static hsm_event_t handle(Device& m, hsm_event_t event, void* data);
+};
+
+struct Active : hsmpp::state<System> {
+    static hsm_event_t handle(Device& m, hsm_event_t event, void* data);
+};
+
+struct Mode1 : hsmpp::state<Active> {
+    static hsm_event_t handle(Device& m, hsm_event_t event, void* data);
+};
+
+struct Mode2 : hsmpp::state<Active> {
+    static hsm_event_t handle(Device& m, hsm_event_t event, void* data);
+};
+
+struct Standby : hsmpp::state<System> {
+    static hsm_event_t handle(Device& m, hsm_event_t event, void* data);
+};
+
+/**
+ * \brief           Machine type, holds application data next to the HSM
+ */
+struct Device : hsmpp::machine<Device, System, Active, Mode1, Mode2, Standby> {
+    unsigned presses = 0;
+};
+
+hsm_event_t
+System::handle(Device& m, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[SYSTEM] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[SYSTEM] Exit\n"); break;
+
+        case EVT_COMMON_ACTION:
+            printf("[SYSTEM] Common action handled\n");
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+hsm_event_t
+Active::handle(Device& m, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[ACTIVE] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[ACTIVE] Exit\n"); break;
+
+        case EVT_TIMEOUT:
+            printf("[ACTIVE] Timeout -> STANDBY\n");
+            m.transition<Standby>();
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+hsm_event_t
+Mode1::handle(Device& m, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[MODE1] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[MODE1] Exit\n"); break;
+
+        case EVT_MODE_CHANGE:
+            printf("[MODE1] Change -> MODE2\n");
+            m.transition<Mode2>();
+            return HSM_EVENT_NONE;
+
+        case EVT_BUTTON_PRESS:
+            printf("[MODE1] Button pressed (%u)\n", ++m.presses);
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+hsm_event_t
+Mode2::handle(Device& m, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[MODE2] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[MODE2] Exit\n"); break;
+
+        case EVT_MODE_CHANGE:
+            printf("[MODE2] Change -> MODE1\n");
+            m.transition<Mode1>();
+            return HSM_EVENT_NONE;
+
+        case EVT_BUTTON_PRESS:
+            printf("[MODE2] Button pressed (%u)\n", ++m.presses);
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+hsm_event_t
+Standby::handle(Device& m, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[STANDBY] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[STANDBY] Exit\n"); break;
+
+        case EVT_BUTTON_PRESS:
+            printf("[STANDBY] Wake -> MODE1\n");
+            m.transition<Mode1>();
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+/**
+ * \brief           Main
+ */
+extern "C" void
+app_main(void) {
+    static Device dev;
+
+    printf("=== HSM C++ Example ===\n\n");
+
+    dev.start<Mode1>();
+
+    printf("\n--- Test 1: Button in MODE1 ---\n");
+    dev.dispatch(EVT_BUTTON_PRESS);
+
+    printf("\n--- Test 2: MODE1 -> MODE2 ---\n");
+    dev.dispatch(EVT_MODE_CHANGE);
+
+    printf("\n--- Test 3: Button in MODE2 ---\n");
+    dev.dispatch(EVT_BUTTON_PRESS);
+
+    printf("\n--- Test 4: Common action (propagate to SYSTEM) ---\n");
+    dev.dispatch(EVT_COMMON_ACTION);
+
+    printf("\n--- Test 5: Timeout (handled by ACTIVE) ---\n");
+    dev.dispatch(EVT_TIMEOUT);
+
+    printf("\n--- Test 6: Wake from STANDBY ---\n");
+    dev.dispatch(EVT_BUTTON_PRESS);
+
+    printf("\n--- Test 7: State membership ---\n");
+    if (dev.is_in_state<Mode1>()) {
+        printf("In MODE1\n");
+    }
+    if (dev.is_in_state<Active>()) {
+        printf("In ACTIVE\n");
+    }
+    if (dev.is_in_state<System>()) {
+        printf("In SYSTEM\n");
+    }
+
+    printf("\n=== Complete ===\n");
+}
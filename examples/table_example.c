@@ -0,0 +1,150 @@
+/**
+ * \file            table_example.c
+ * \brief           Compact state table example
+ *
+ * Requires `HSM_CFG_TABLE` enabled.
+ */
+
+#include "hsm_table.h"
+#include <stdio.h>
+
+/* Events */
+typedef enum {
+    EVT_BUTTON_PRESS = HSM_EVENT_USER,
+    EVT_TIMEOUT,
+    EVT_MODE_CHANGE,
+} app_events_t;
+
+/* State indices */
+enum {
+    ST_SYSTEM,
+    ST_ACTIVE,
+    ST_MODE1,
+    ST_MODE2,
+    ST_STANDBY,
+    ST_COUNT,
+};
+
+/**
+ * \brief           SYSTEM root state handler
+ */
+static hsm_event_t
+system_handler(hsm_table_inst_t* inst, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[SYSTEM] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[SYSTEM] Exit\n"); break;
+    }
+    return event;
+}
+
+/**
+ * \brief           ACTIVE parent state handler
+ */
+static hsm_event_t
+active_handler(hsm_table_inst_t* inst, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[ACTIVE] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[ACTIVE] Exit\n"); break;
+
+        case EVT_TIMEOUT:
+            printf("[ACTIVE] Timeout -> STANDBY\n");
+            hsm_table_transition(inst, ST_STANDBY, NULL, NULL);
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+/**
+ * \brief           MODE1 and MODE2 share one handler
+ */
+static hsm_event_t
+mode_handler(hsm_table_inst_t* inst, hsm_event_t event, void* data) {
+    uint8_t self = inst->active;
+    const char* name = hsm_table_state_name(inst->table, self);
+
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[%s] Entry\n", name); break;
+        case HSM_EVENT_EXIT: printf("[%s] Exit\n", name); break;
+
+        case EVT_MODE_CHANGE:
+            printf("[%s] Change\n", name);
+            hsm_table_transition(inst, self == ST_MODE1 ? ST_MODE2 : ST_MODE1, NULL, NULL);
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+/**
+ * \brief           STANDBY state handler
+ */
+static hsm_event_t
+standby_handler(hsm_table_inst_t* inst, hsm_event_t event, void* data) {
+    switch (event) {
+        case HSM_EVENT_ENTRY: printf("[STANDBY] Entry\n"); break;
+        case HSM_EVENT_EXIT: printf("[STANDBY] Exit\n"); break;
+
+        case EVT_BUTTON_PRESS:
+            printf("[STANDBY] Wake -> MODE1\n");
+            hsm_table_transition(inst, ST_MODE1, NULL, NULL);
+            return HSM_EVENT_NONE;
+    }
+    return event;
+}
+
+/* Everything below is constant and can be placed in flash */
+static const hsm_table_fn_t handlers[] = {
+    system_handler,
+    active_handler,
+    mode_handler,
+    standby_handler,
+};
+
+static const hsm_table_state_t states[ST_COUNT] = {
+    [ST_SYSTEM] = HSM_TABLE_STATE(HSM_TABLE_NONE, 0),
+    [ST_ACTIVE] = HSM_TABLE_STATE(ST_SYSTEM, 1),
+    [ST_MODE1] = HSM_TABLE_STATE(ST_ACTIVE, 2),
+    [ST_MODE2] = HSM_TABLE_STATE(ST_ACTIVE, 2),
+    [ST_STANDBY] = HSM_TABLE_STATE(ST_SYSTEM, 3),
+};
+
+static const char* const names[ST_COUNT] = {"SYSTEM", "ACTIVE", "MODE1", "MODE2", "STANDBY"};
+
+static const hsm_table_t machine = {
+    .states = states,
+    .handlers = handlers,
+    .names = names,
+    .count = ST_COUNT,
+    .handler_count = sizeof(handlers) / sizeof(handlers[0]),
+};
+
+/**
+ * \brief           Main
+ */
+void
+app_main(void) {
+    hsm_table_inst_t inst;
+
+    printf("=== HSM Table Example ===\n\n");
+
+    if (hsm_table_check(&machine) != HSM_RES_OK) {
+        printf("Invalid machine definition\n");
+        return;
+    }
+    hsm_table_init(&inst, &machine, ST_MODE1);
+
+    printf("\n--- Test 1: MODE1 -> MODE2 ---\n");
+    hsm_table_dispatch(&inst, EVT_MODE_CHANGE, NULL);
+
+    printf("\n--- Test 2: Timeout (handled by ACTIVE) ---\n");
+    hsm_table_dispatch(&inst, EVT_TIMEOUT, NULL);
+
+    printf("\n--- Test 3: Wake from STANDBY ---\n");
+    hsm_table_dispatch(&inst, EVT_BUTTON_PRESS, NULL);
+
+    printf("\n--- Test 4: State membership ---\n");
+    if (hsm_table_is_in_state(&inst, ST_ACTIVE)) {
+        printf("In ACTIVE\n");
+    }
+
+    printf("\n=== Complete ===\n");
+}
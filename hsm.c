@@ -32,21 +32,179 @@
  */
 #include "hsm.h"
 #include <stddef.h>
+#include <string.h>
+
+#if HSM_CFG_QUEUE || HSM_CFG_EVENT_POOL || HSM_CFG_TRACE || HSM_CFG_STATS
+#include "hsm_port.h"
+#endif /* HSM_CFG_QUEUE || HSM_CFG_EVENT_POOL || HSM_CFG_TRACE || HSM_CFG_STATS */
+#if HSM_CFG_TIMER
+#include "hsm_timer.h"
+#endif /* HSM_CFG_TIMER */
+
+#define PRV_TRACE_HIST (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM)
+
+#define PRV_TRACE_RING (HSM_CFG_TRACE && HSM_CFG_TRACE_RING)
+
+/* Per-state counters are kept by the instance, see hsm_set_state_slots() */
+#define PRV_STATE_SLOTS (HSM_CFG_STATS || PRV_TRACE_HIST)
+
+#if HSM_CFG_STATS
+/* Counters are read and reset from other tasks while the machine runs */
+#define PRV_STAT_INC(counter) ((void)HSM_ATOMIC_FETCH_ADD(&(counter), 1))
+#else
+#define PRV_STAT_INC(counter)
+#endif /* HSM_CFG_STATS */
+
+#if PRV_TRACE_RING
+#if (HSM_CFG_TRACE_RING_SIZE & (HSM_CFG_TRACE_RING_SIZE - 1)) != 0
+#error "HSM_CFG_TRACE_RING_SIZE must be a power of two"
+#endif
+
+static hsm_trace_record_t prv_ring[HSM_CFG_TRACE_RING_SIZE];
+static uint32_t prv_ring_head;                /* Total number of records written */
+static uint32_t prv_ring_state_ids;           /* Next state id */
+static uint32_t prv_ring_hsm_ids;             /* Next HSM id */
+static const char* prv_ring_state_names[HSM_CFG_TRACE_RING_NAMES];
+static const char* prv_ring_hsm_names[HSM_CFG_TRACE_RING_NAMES];
+static const void* prv_ring_state_owners[HSM_CFG_TRACE_RING_NAMES];
+static const void* prv_ring_hsm_owners[HSM_CFG_TRACE_RING_NAMES];
 
 /**
- * \brief           Calculate state depth in hierarchy
- * \param[in]       state: Pointer to state
- * \return          Depth level, 0 for root
+ * \brief           Get trace id of a state or HSM instance
+ *
+ * An object that already has a name slot keeps its id and only updates
+ * its name, so re-initialising or restoring it does not use up ids.
+ * Objects beyond the name table get a new id every time.
+ *
+ * \param[in]       owners: Object of each name slot
+ * \param[in]       names: Name table
+ * \param[in]       ids: Next id counter
+ * \param[in]       owner: State or HSM instance
+ * \param[in]       name: Its name
+ * \return          Trace id
  */
-static uint8_t
-prv_get_state_depth(hsm_state_t* state) {
-    uint8_t depth = 0;
-    while (state != NULL && state->parent != NULL) {
-        depth++;
-        state = state->parent;
+static uint32_t
+prv_ring_id(const void** owners, const char** names, uint32_t* ids, const void* owner, const char* name) {
+    uint32_t id = HSM_ATOMIC_LOAD(ids);
+
+    for (uint32_t i = 0; i < id && i < HSM_CFG_TRACE_RING_NAMES; i++) {
+        if (HSM_ATOMIC_LOAD(&owners[i]) == owner) {
+            names[i] = name;
+            return i;
+        }
+    }
+    id = HSM_ATOMIC_FETCH_ADD(ids, 1);
+    if (id < HSM_CFG_TRACE_RING_NAMES) {
+        names[id] = name;
+        HSM_ATOMIC_STORE(&owners[id], owner);
+    }
+    return id;
+}
+
+/**
+ * \brief           Store trace record in ring buffer
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       type: Trace point type
+ * \param[in]       state: State involved, can be `NULL`
+ * \param[in]       event: Event involved
+ */
+static void
+prv_ring_write(hsm_t* hsm, hsm_trace_type_t type, const hsm_state_t* state, hsm_event_t event) {
+    uint32_t pos = HSM_ATOMIC_FETCH_ADD(&prv_ring_head, 1);
+    hsm_trace_record_t* r = &prv_ring[pos & (HSM_CFG_TRACE_RING_SIZE - 1)];
+
+    r->timestamp = HSM_PORT_CYCLES();
+    r->event = event;
+    r->state = (state != NULL) ? state->id : HSM_TRACE_ID_NONE;
+    r->hsm = hsm->id;
+    r->type = (uint8_t)type;
+}
+#endif /* PRV_TRACE_RING */
+
+#if HSM_CFG_TRACE
+/**
+ * \brief           Trace point
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       type: Trace point type
+ * \param[in]       state: State involved, can be `NULL`
+ * \param[in]       event: Event involved
+ */
+static inline void
+prv_trace(hsm_t* hsm, hsm_trace_type_t type, const hsm_state_t* state, hsm_event_t event) {
+#if PRV_TRACE_RING
+    prv_ring_write(hsm, type, state, event);
+#endif /* PRV_TRACE_RING */
+#ifdef HSM_CFG_TRACE_HOOK
+    HSM_CFG_TRACE_HOOK(hsm, type, state, event);
+#endif /* HSM_CFG_TRACE_HOOK */
+    (void)hsm;
+    (void)type;
+    (void)state;
+    (void)event;
+}
+
+/* Trace point, compiles to nothing when tracing is disabled */
+#define HSM_TRACE(hsm, type, state, event) prv_trace((hsm), (type), (state), (event))
+#else
+#define HSM_TRACE(hsm, type, state, event)
+#endif /* HSM_CFG_TRACE */
+
+#if PRV_TRACE_HIST
+/**
+ * \brief           Add latency sample to histogram
+ * \param[in]       hist: Histogram
+ * \param[in]       start: Cycle counter value at start of measured section
+ */
+static void
+prv_hist_add(hsm_trace_hist_t* hist, uint32_t start) {
+    uint32_t cycles = HSM_PORT_CYCLES() - start;
+    uint8_t bin = 0;
+
+    while (cycles > 1 && bin < HSM_CFG_TRACE_HISTOGRAM_BINS - 1) {
+        cycles >>= 1;
+        bin++;
+    }
+    /* Bins are read and cleared by other tasks while the machine runs */
+    HSM_ATOMIC_FETCH_ADD(&hist->bins[bin], 1);
+}
+#endif /* PRV_TRACE_HIST */
+
+#if PRV_STATE_SLOTS
+/**
+ * \brief           Find per-instance record of state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State to look up
+ * \return          Record of `state`, `NULL` when the instance does not record it
+ */
+static hsm_state_slot_t*
+prv_state_slot(const hsm_t* hsm, const hsm_state_t* state) {
+    hsm_state_slot_t* slot;
+
+    /* Position is shared by every instance, the set of this one may be shorter */
+    if (state->slot == 0 || state->slot > hsm->state_slot_count) {
+        return NULL;
+    }
+    slot = &hsm->state_slots[state->slot - 1];
+    return (slot->state == state) ? slot : NULL;
+}
+#endif /* PRV_STATE_SLOTS */
+
+#if PRV_TRACE_HIST
+/**
+ * \brief           Add handler latency sample to record of state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State whose handler ran
+ * \param[in]       start: Cycle counter value before the handler
+ */
+static void
+prv_state_hist_add(const hsm_t* hsm, const hsm_state_t* state, uint32_t start) {
+    hsm_state_slot_t* slot = prv_state_slot(hsm, state);
+
+    if (slot != NULL) {
+        prv_hist_add(&slot->latency, start);
     }
-    return depth;
 }
+#endif /* PRV_TRACE_HIST */
 
 /**
  * \brief           Find lowest common ancestor of two states
@@ -54,10 +212,10 @@ prv_get_state_depth(hsm_state_t* state) {
  * \param[in]       state2: Second state
  * \return          Pointer to LCA state
  */
-static hsm_state_t*
-prv_find_lca(hsm_state_t* state1, hsm_state_t* state2) {
+static const hsm_state_t*
+prv_find_lca(const hsm_state_t* state1, const hsm_state_t* state2) {
     uint8_t depth1, depth2;
-    hsm_state_t *s1, *s2;
+    const hsm_state_t *s1, *s2;
 
     if (state1 == NULL || state2 == NULL) {
         return NULL;
@@ -65,15 +223,15 @@ prv_find_lca(hsm_state_t* state1, hsm_state_t* state2) {
 
     s1 = state1;
     s2 = state2;
-    depth1 = prv_get_state_depth(s1);
-    depth2 = prv_get_state_depth(s2);
+    depth1 = s1->depth;
+    depth2 = s2->depth;
 
     /* Bring both states to same level */
-    while (depth1 > depth2) {
+    while (depth1 > depth2 && s1 != NULL) {
         s1 = s1->parent;
         depth1--;
     }
-    while (depth2 > depth1) {
+    while (depth2 > depth1 && s2 != NULL) {
         s2 = s2->parent;
         depth2--;
     }
@@ -88,188 +246,394 @@ prv_find_lca(hsm_state_t* state1, hsm_state_t* state2) {
 }
 
 /**
- * \brief           Execute state handler
+ * \brief           Invoke state handler
  * \param[in]       hsm: Pointer to HSM instance
- * \param[in]       state: State to execute
- * \param[in]       event: Event to dispatch
+ * \param[in]       state: State whose handler to call
+ * \param[in]       event: Event to pass
  * \param[in]       data: Event data
+ * \return          Event returned by handler
  */
-static void
-prv_execute_state(hsm_t* hsm, hsm_state_t* state, hsm_event_t event, void* data) {
-    if (state != NULL && state->handler != NULL) {
-        state->handler(hsm, event, data);
+static hsm_event_t
+prv_call_handler(hsm_t* hsm, const hsm_state_t* state, hsm_event_t event, void* data) {
+#if PRV_TRACE_HIST
+    uint32_t start = HSM_PORT_CYCLES();
+#endif /* PRV_TRACE_HIST */
+
+#if HSM_CFG_GUARDS
+    /* First transition with matching event and passing guard wins, system events have none */
+    for (uint8_t i = 0; event >= HSM_EVENT_USER && i < state->transition_count; ++i) {
+        const hsm_transition_t* t = &state->transitions[i];
+
+        if (t->event != event || (t->guard != NULL && !t->guard(hsm, event, data))) {
+            continue;
+        }
+        if (t->target != NULL) {
+            hsm_transition(hsm, t->target, data, t->action);
+        } else if (t->action != NULL) {
+            t->action(hsm, data);
+        }
+#if PRV_TRACE_HIST
+        prv_state_hist_add(hsm, state, start);
+#endif /* PRV_TRACE_HIST */
+        return HSM_EVENT_NONE;
     }
-}
+#endif /* HSM_CFG_GUARDS */
+#if HSM_CFG_EVENT_TABLE
+    /* Single bounds check, events below `table_first` wrap around */
+    if (state->table != NULL && event - state->table_first < state->table_count
+        && (state->table[event - state->table_first].action != NULL
+            || state->table[event - state->table_first].target != NULL)) {
+        const hsm_event_entry_t* entry = &state->table[event - state->table_first];
 
-/**
- * \brief           Initialize HSM state
- * \param[in]       state: Pointer to state structure
- * \param[in]       name: State name
- * \param[in]       handler: State handler function
- * \param[in]       parent: Parent state (NULL for root)
- * \return          \ref HSM_RES_OK on success
- */
-hsm_result_t
-hsm_state_create(hsm_state_t* state, const char* name, hsm_state_fn_t handler,
-                 hsm_state_t* parent) {
-    if (state == NULL || handler == NULL) {
-        return HSM_RES_INVALID_PARAM;
+        if (entry->action != NULL) {
+            event = entry->action(hsm, event, data);
+        } else {
+            event = HSM_EVENT_NONE;
+        }
+        if (event == HSM_EVENT_NONE && entry->target != NULL) {
+            hsm_transition(hsm, entry->target, NULL, NULL);
+        }
+    } else
+#endif /* HSM_CFG_EVENT_TABLE */
+    {
+        event = state->handler(hsm, event, data);
     }
+#if PRV_TRACE_HIST
+    prv_state_hist_add(hsm, state, start);
+#endif /* PRV_TRACE_HIST */
+    return event;
+}
 
-    state->name = name;
-    state->handler = handler;
-    state->parent = parent;
+#if HSM_CFG_EVENT_DEFER
+#define PRV_DEFER_RECALL 0x01                 /* Deferring state exited, store must be recalled */
+#define PRV_DEFER_BUSY   0x02                 /* Dispatch or recall running, recall waits for it */
+#endif /* HSM_CFG_EVENT_DEFER */
 
-    return HSM_RES_OK;
-}
+#if HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER
+/* Check if user event has a bit in event masks */
+#define PRV_EVENT_IN_MASK(evt)                                                                     \
+    ((evt) >= HSM_EVENT_USER && (evt) - HSM_EVENT_USER < HSM_CFG_EVENT_MASK_BITS)
+#endif /* HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER */
+
+/* Reject events outside the handled union of the active chain before any handler runs */
+#define PRV_FAST_REJECT (HSM_CFG_UNHANDLED && HSM_CFG_EVENT_MASK)
 
+#if PRV_FAST_REJECT
+/* Bumped when a state definition changes, invalidates cached unions */
+static uint32_t prv_mask_gen;
+#endif /* PRV_FAST_REJECT */
+
+#if HSM_CFG_REGIONS
+static void prv_regions_enter(hsm_t* hsm, const hsm_state_t* owner);
+static void prv_regions_exit(hsm_t* hsm, const hsm_state_t* owner);
+#endif /* HSM_CFG_REGIONS */
+
+#if HSM_CFG_STATE_HISTORY
 /**
- * \brief           Initialize HSM instance
+ * \brief           Get recorded history of composite state
  * \param[in]       hsm: Pointer to HSM instance
- * \param[in]       name: HSM name
- * \param[in]       initial_state: Initial state
- * \return          \ref HSM_RES_OK on success
+ * \param[in]       composite: State with a history pseudo-state
+ * \return          Active leaf when `composite` was last exited, `NULL` if not recorded
  */
-hsm_result_t
-hsm_init(hsm_t* hsm, const char* name, hsm_state_t* initial_state) {
-    if (hsm == NULL || initial_state == NULL) {
-        return HSM_RES_INVALID_PARAM;
+static const hsm_state_t*
+prv_history_get(const hsm_t* hsm, const hsm_state_t* composite) {
+    for (uint8_t i = 0; i < HSM_CFG_HISTORY_SLOTS; i++) {
+        if (hsm->history_slots[i].composite == composite) {
+            return hsm->history_slots[i].last_active;
+        }
     }
+    return NULL;
+}
 
-    hsm->name = name;
-    hsm->current = initial_state;
-    hsm->initial = initial_state;
-    hsm->next = NULL;
-    hsm->depth = prv_get_state_depth(initial_state);
-    hsm->in_transition = 0;
-
-#if HSM_CFG_HISTORY
-    hsm->history = NULL;
-#endif /* HSM_CFG_HISTORY */
-
-    /* Enter initial state */
-    hsm->in_transition = 1;
-    prv_execute_state(hsm, initial_state, HSM_EVENT_ENTRY, NULL);
-    hsm->in_transition = 0;
+/**
+ * \brief           Record history of composite state
+ *
+ * Nothing is recorded when all slots are taken by other composite states.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       composite: State with a history pseudo-state
+ * \param[in]       leaf: Active leaf to resume
+ */
+static void
+prv_history_set(hsm_t* hsm, const hsm_state_t* composite, const hsm_state_t* leaf) {
+    hsm_history_slot_t* slot = NULL;
 
-    /* Check if deferred transition was requested in ENTRY */
-    if (hsm->next != NULL) {
-        hsm_state_t* next_state = hsm->next;
-        hsm->next = NULL;
-        return hsm_transition(hsm, next_state, NULL, NULL);
+    for (uint8_t i = 0; i < HSM_CFG_HISTORY_SLOTS; i++) {
+        if (hsm->history_slots[i].composite == composite) {
+            slot = &hsm->history_slots[i];
+            break;
+        }
+        if (slot == NULL && hsm->history_slots[i].composite == NULL) {
+            slot = &hsm->history_slots[i];
+        }
+    }
+    if (slot != NULL) {
+        slot->composite = composite;
+        slot->last_active = leaf;
     }
-
-    return HSM_RES_OK;
 }
+#endif /* HSM_CFG_STATE_HISTORY */
 
 /**
- * \brief           Get current state
+ * \brief           Execute state handler
  * \param[in]       hsm: Pointer to HSM instance
- * \return          Pointer to current state
+ * \param[in]       state: State to execute
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
  */
-hsm_state_t*
-hsm_get_current_state(hsm_t* hsm) {
-    return (hsm != NULL) ? hsm->current : NULL;
+static void
+prv_execute_state(hsm_t* hsm, const hsm_state_t* state, hsm_event_t event, void* data) {
+#if HSM_CFG_STATS
+    {
+        hsm_state_slot_t* slot = (state != NULL) ? prv_state_slot(hsm, state) : NULL;
+
+        if (slot != NULL) {
+            PRV_STAT_INC(*(event == HSM_EVENT_EXIT ? &slot->stats.exits : &slot->stats.entries));
+        }
+    }
+#endif /* HSM_CFG_STATS */
+#if HSM_CFG_STATE_HISTORY
+    /* Current state is still the leaf being left, state itself stays untouched */
+    if (event == HSM_EVENT_EXIT && state != NULL && state->keeps_history) {
+        prv_history_set(hsm, state, hsm->current);
+    }
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_EVENT_DEFER
+    /* Postponed events get another chance once the transition completes */
+    if (event == HSM_EVENT_EXIT && state != NULL && state->defer != 0 && hsm->defer_count > 0) {
+        hsm->defer_flags |= PRV_DEFER_RECALL;
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+#if HSM_CFG_REGIONS
+    /* Regions are left before their composite state */
+    if (event == HSM_EVENT_EXIT && hsm->regions != NULL) {
+        prv_regions_exit(hsm, state);
+    }
+#endif /* HSM_CFG_REGIONS */
+    if (state != NULL && state->handler != NULL) {
+        HSM_TRACE(hsm, event == HSM_EVENT_EXIT ? HSM_TRACE_EXIT : HSM_TRACE_ENTRY, state, event);
+#if HSM_CFG_ASYNC
+        /* Entry continues when the handler completes it from a later event */
+        if (prv_call_handler(hsm, state, event, data) == HSM_EVENT_PENDING
+            && event == HSM_EVENT_ENTRY) {
+            hsm->async_state = state;
+            return;
+        }
+#else
+        prv_call_handler(hsm, state, event, data);
+#endif /* HSM_CFG_ASYNC */
+    }
+#if HSM_CFG_TIMER
+    /* Time events bound to the state end with it */
+    if (event == HSM_EVENT_EXIT && hsm->timers != NULL) {
+        hsm_timer_exit_state(hsm, state);
+    }
+#endif /* HSM_CFG_TIMER */
+#if HSM_CFG_REGIONS
+    /* Regions are entered after their composite state */
+    if (event == HSM_EVENT_ENTRY && hsm->regions != NULL) {
+        prv_regions_enter(hsm, state);
+    }
+#endif /* HSM_CFG_REGIONS */
 }
 
+#if HSM_CFG_COMPILED
 /**
- * \brief           Check if in specific state
+ * \brief           Check if a transition can use the compiled table
+ *
+ * The dynamic path is used when either state is not part of the
+ * compiled state set attached to the HSM instance.
+ *
  * \param[in]       hsm: Pointer to HSM instance
- * \param[in]       state: State to check
- * \return          1 if in state or parent, 0 otherwise
+ * \param[in]       target: Target state
+ * \return          `1` if both states are compiled, `0` otherwise
  */
-uint8_t
-hsm_is_in_state(hsm_t* hsm, hsm_state_t* state) {
-    hsm_state_t* current;
+static uint8_t
+prv_compiled_match(const hsm_t* hsm, const hsm_state_t* target) {
+    const hsm_compiled_t* c = hsm->compiled;
+    uint8_t src, dst;
 
-    if (hsm == NULL || state == NULL) {
+    if (c == NULL) {
         return 0;
     }
+    src = hsm->current->index;
+    dst = target->index;
+    return src < c->count && c->states[src] == hsm->current && dst < c->count && c->states[dst] == target;
+}
 
-    current = hsm->current;
-    while (current != NULL) {
-        if (current == state) {
-            return 1;
-        }
-        current = current->parent;
+/**
+ * \brief           Execute transition using compiled table
+ * \param[in]       hsm: Pointer to HSM instance, \ref prv_compiled_match passed
+ * \param[in]       target: Target state
+ * \param[in]       param: Parameter passed to ENTRY and EXIT events
+ * \param[in]       method: Optional hook function called between EXIT and ENTRY
+ */
+static void
+prv_compiled_transition(hsm_t* hsm, const hsm_state_t* target, void* param,
+                        void (*method)(hsm_t* hsm, void* param)) {
+    const hsm_compiled_t* c = hsm->compiled;
+    const hsm_state_t* const* src_path;
+    const hsm_state_t* const* dst_path;
+    uint8_t src = hsm->current->index, dst = target->index, common, src_len, dst_len, i;
+
+    common = c->table[src * c->count + dst];
+    src_len = c->table[src * c->count + src];
+    dst_len = c->table[dst * c->count + dst];
+    src_path = &c->paths[src * HSM_CFG_MAX_DEPTH];
+    dst_path = &c->paths[dst * HSM_CFG_MAX_DEPTH];
+
+    hsm->in_transition = 1;
+
+    /* Exit from current state up to, not including, common ancestor */
+    for (i = src_len; i > common; i--) {
+        prv_execute_state(hsm, src_path[i - 1], HSM_EVENT_EXIT, param);
     }
 
-    return 0;
+    if (method != NULL) {
+        method(hsm, param);
+    }
+
+    /* Enter from below common ancestor down to target */
+    for (i = common; i < dst_len; i++) {
+        prv_execute_state(hsm, dst_path[i], HSM_EVENT_ENTRY, param);
+#if HSM_CFG_ASYNC
+        if (hsm->async_state != NULL) {
+            break;
+        }
+#endif /* HSM_CFG_ASYNC */
+    }
 }
+#endif /* HSM_CFG_COMPILED */
 
+#if HSM_CFG_STATE_HISTORY
 /**
- * \brief           Dispatch event to current state
+ * \brief           Resolve history pseudo-state to the state to enter
  * \param[in]       hsm: Pointer to HSM instance
- * \param[in]       event: Event to dispatch
- * \param[in]       data: Event data
- * \return          \ref HSM_RES_OK on success
+ * \param[in]       pseudo: History pseudo-state
+ * \return          Recorded child or leaf, the composite itself on first entry
  */
-hsm_result_t
-hsm_dispatch(hsm_t* hsm, hsm_event_t event, void* data) {
-    hsm_state_t* state;
-    hsm_event_t evt;
+static const hsm_state_t*
+prv_resolve_history(hsm_t* hsm, const hsm_state_t* pseudo) {
+    const hsm_state_t* composite = pseudo->parent;
+    const hsm_state_t* state = prv_history_get(hsm, composite);
 
-    if (hsm == NULL) {
-        return HSM_RES_INVALID_PARAM;
+    if (state == NULL || state == composite) {
+        return composite;
     }
-
-    state = hsm->current;
-    evt = event;
-
-    /* Propagate event up the state hierarchy */
-    while (state != NULL && evt != HSM_EVENT_NONE) {
-        evt = state->handler(hsm, evt, data);
-        state = state->parent;
+    if (pseudo->history == HSM_HISTORY_SHALLOW) {
+        while (state->parent != composite) {
+            state = state->parent;
+        }
     }
+    return state;
+}
 
-    return HSM_RES_OK;
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_ASYNC
+/**
+ * \brief           Park transition at a pending ENTRY handler
+ *
+ * The pending state becomes current, `in_transition` stays set so that
+ * requested transitions are queued until the entry completes.
+ *
+ * \param[in]       hsm: Pointer to HSM instance, `async_state` set
+ * \param[in]       target: Final state of the transition
+ * \param[in]       param: Transition parameter, passed to remaining ENTRY handlers
+ */
+static void
+prv_async_suspend(hsm_t* hsm, const hsm_state_t* target, void* param) {
+    hsm->async_target = target;
+    hsm->async_param = param;
+    hsm->current = hsm->async_state;
+    hsm->depth = hsm->current->depth;
 }
+#endif /* HSM_CFG_ASYNC */
 
 /**
- * \brief           Transition to target state
+ * \brief           Execute one transition, `in_transition` must be clear
+ *
+ * Both paths are built before any handler runs. A path longer than
+ * `HSM_CFG_MAX_DEPTH`, only possible for states not built by
+ * \ref hsm_state_create, aborts the transition without any EXIT or ENTRY.
+ *
  * \param[in]       hsm: Pointer to HSM instance
  * \param[in]       target: Target state
  * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
  * \param[in]       method: Optional hook function called between EXIT and ENTRY
- * \return          \ref HSM_RES_OK on success
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_MAX_DEPTH if a path
+ *                  does not fit the path buffers
  */
-hsm_result_t
-hsm_transition(hsm_t* hsm, hsm_state_t* target, void* param,
-               void (*method)(hsm_t* hsm, void* param)) {
-    hsm_state_t* lca;
-    hsm_state_t* exit_path[HSM_CFG_MAX_DEPTH];
-    hsm_state_t* entry_path[HSM_CFG_MAX_DEPTH];
-    uint8_t exit_count, entry_count, i;
+static hsm_result_t
+prv_transition(hsm_t* hsm, const hsm_state_t* target, void* param, void (*method)(hsm_t* hsm, void* param)) {
+    const hsm_state_t* lca;
+    const hsm_state_t* exit_path[HSM_CFG_MAX_DEPTH];
+    const hsm_state_t* entry_path[HSM_CFG_MAX_DEPTH];
+    uint8_t exit_count = 0, entry_count = 0, i;
+#if HSM_CFG_COMPILED
+    uint8_t compiled;
+#endif /* HSM_CFG_COMPILED */
+#if PRV_TRACE_HIST
+    uint32_t start;
+#endif /* PRV_TRACE_HIST */
 
-    if (hsm == NULL || target == NULL) {
-        return HSM_RES_INVALID_PARAM;
+#if HSM_CFG_STATE_HISTORY
+    if (target->history != HSM_HISTORY_NONE) {
+        target = prv_resolve_history(hsm, target);
     }
+#endif /* HSM_CFG_STATE_HISTORY */
 
-    /* If already in transition, defer this transition */
-    if (hsm->in_transition) {
-        hsm->next = target;
-        return HSM_RES_OK;
+#if HSM_CFG_INITIAL
+    /* Descend to leaf, its entry path includes the default children */
+    while (target->initial != NULL) {
+        target = target->initial;
     }
+#endif /* HSM_CFG_INITIAL */
+
+#if HSM_CFG_COMPILED
+    /* Compiled paths are bounded by hsm_compile() */
+    compiled = prv_compiled_match(hsm, target);
+    if (!compiled)
+#endif /* HSM_CFG_COMPILED */
+    {
+        /* Find lowest common ancestor */
+        lca = prv_find_lca(hsm->current, target);
+
+        /* Build exit path from current to LCA */
+        for (const hsm_state_t* state = hsm->current; state != lca; state = state->parent) {
+            if (exit_count == HSM_CFG_MAX_DEPTH) {
+                HSM_TRACE(hsm, HSM_TRACE_TRANSITION_ABORT, target, HSM_EVENT_NONE);
+                return HSM_RES_MAX_DEPTH;
+            }
+            exit_path[exit_count++] = state;
+        }
+
+        /* Build entry path from LCA to target */
+        for (const hsm_state_t* state = target; state != lca; state = state->parent) {
+            if (entry_count == HSM_CFG_MAX_DEPTH) {
+                HSM_TRACE(hsm, HSM_TRACE_TRANSITION_ABORT, target, HSM_EVENT_NONE);
+                return HSM_RES_MAX_DEPTH;
+            }
+            entry_path[entry_count++] = state;
+        }
+    }
+
+    HSM_TRACE(hsm, HSM_TRACE_TRANSITION_BEGIN, target, HSM_EVENT_NONE);
+    PRV_STAT_INC(hsm->stats.transitions);
+#if PRV_TRACE_HIST
+    start = HSM_PORT_CYCLES();
+#endif /* PRV_TRACE_HIST */
 
 #if HSM_CFG_HISTORY
     /* Save current state to history */
     hsm->history = hsm->current;
 #endif /* HSM_CFG_HISTORY */
 
-    /* Find lowest common ancestor */
-    lca = prv_find_lca(hsm->current, target);
-
-    /* Build exit path from current to LCA */
-    exit_count = 0;
-    for (hsm_state_t* state = hsm->current; state != lca; state = state->parent) {
-        exit_path[exit_count++] = state;
-    }
-
-    /* Build entry path from LCA to target */
-    entry_count = 0;
-    for (hsm_state_t* state = target; state != lca; state = state->parent) {
-        entry_path[entry_count++] = state;
+#if HSM_CFG_COMPILED
+    if (compiled) {
+        prv_compiled_transition(hsm, target, param, method);
+        goto transition_done;
     }
+#endif /* HSM_CFG_COMPILED */
 
     hsm->in_transition = 1;
 
@@ -286,40 +650,2662 @@ hsm_transition(hsm_t* hsm, hsm_state_t* target, void* param,
     /* Execute entry actions in reverse order with param */
     for (i = entry_count; i > 0; i--) {
         prv_execute_state(hsm, entry_path[i - 1], HSM_EVENT_ENTRY, param);
+#if HSM_CFG_ASYNC
+        if (hsm->async_state != NULL) {
+            break;
+        }
+#endif /* HSM_CFG_ASYNC */
     }
 
+#if HSM_CFG_COMPILED
+transition_done:
+#endif /* HSM_CFG_COMPILED */
+#if HSM_CFG_ASYNC
+    if (hsm->async_state != NULL) {
+        prv_async_suspend(hsm, target, param);
+        return HSM_RES_OK;
+    }
+#endif /* HSM_CFG_ASYNC */
     /* Update current state */
     hsm->current = target;
-    hsm->depth = prv_get_state_depth(target);
+    hsm->depth = target->depth;
 
     hsm->in_transition = 0;
+    HSM_TRACE(hsm, HSM_TRACE_TRANSITION_END, target, HSM_EVENT_NONE);
+#if PRV_TRACE_HIST
+    prv_hist_add(&hsm->transition_latency, start);
+#endif /* PRV_TRACE_HIST */
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Execute deferred transitions in request order
+ *
+ * Transitions requested by handlers of a deferred transition are appended
+ * to the same queue, so chains of any length run with constant stack usage.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ */
+static void
+prv_run_deferred(hsm_t* hsm) {
+    hsm_deferred_t d;
+
+    while (hsm->deferred_count > 0) {
+#if HSM_CFG_ASYNC
+        /* Rest waits for the pending entry */
+        if (hsm->async_state != NULL) {
+            return;
+        }
+#endif /* HSM_CFG_ASYNC */
+        d = hsm->deferred[hsm->deferred_head];
+        hsm->deferred_head = (uint8_t)((hsm->deferred_head + 1) % HSM_CFG_DEFER_SIZE);
+        hsm->deferred_count--;
+        prv_transition(hsm, d.target, d.param, d.method);
+    }
+}
+
+/**
+ * \brief           Enter initial state and its default children
+ * \param[in]       hsm: Pointer to HSM instance, reset to its initial state
+ */
+static void
+prv_start(hsm_t* hsm) {
+    /* Enter initial state */
+    hsm->in_transition = 1;
+    prv_execute_state(hsm, hsm->initial, HSM_EVENT_ENTRY, NULL);
+#if HSM_CFG_INITIAL
+    /* Continue into default children */
+    for (const hsm_state_t* state = hsm->initial->initial; state != NULL; state = state->initial) {
+#if HSM_CFG_ASYNC
+        if (hsm->async_state != NULL) {
+            break;
+        }
+#endif /* HSM_CFG_ASYNC */
+        prv_execute_state(hsm, state, HSM_EVENT_ENTRY, NULL);
+        hsm->current = state;
+    }
+    hsm->depth = hsm->current->depth;
+#endif /* HSM_CFG_INITIAL */
+#if HSM_CFG_ASYNC
+    if (hsm->async_state != NULL) {
+        const hsm_state_t* leaf = hsm->initial;
 
-    /* Check if deferred transition was requested in ENTRY */
-    if (hsm->next != NULL) {
-        hsm_state_t* next_state = hsm->next;
-        hsm->next = NULL;
-        return hsm_transition(hsm, next_state, NULL, NULL);
+#if HSM_CFG_INITIAL
+        while (leaf->initial != NULL) {
+            leaf = leaf->initial;
+        }
+#endif /* HSM_CFG_INITIAL */
+        prv_async_suspend(hsm, leaf, NULL);
+        return;
     }
+#endif /* HSM_CFG_ASYNC */
+    hsm->in_transition = 0;
 
-    return HSM_RES_OK;
+    /* Run transitions requested in ENTRY */
+    prv_run_deferred(hsm);
 }
 
-#if HSM_CFG_HISTORY
+#if HSM_CFG_ASYNC
 /**
- * \brief           Transition to history state
+ * \brief           Continue transition after its pending ENTRY completed
+ *
+ * Enters the remaining states down to the target, each of which may
+ * suspend again, then completes the transition.
+ *
  * \param[in]       hsm: Pointer to HSM instance
- * \return          \ref HSM_RES_OK on success
  */
-hsm_result_t
-hsm_transition_history(hsm_t* hsm) {
-    if (hsm == NULL) {
-        return HSM_RES_INVALID_PARAM;
+static void
+prv_async_resume(hsm_t* hsm) {
+    const hsm_state_t* path[HSM_CFG_MAX_DEPTH];
+    const hsm_state_t* entered = hsm->async_state;
+    const hsm_state_t* target = hsm->async_target;
+    uint8_t count = 0;
+
+    hsm->async_state = NULL;
+#if HSM_CFG_REGIONS
+    if (hsm->regions != NULL) {
+        prv_regions_enter(hsm, entered);
     }
+#endif /* HSM_CFG_REGIONS */
 
-    if (hsm->history == NULL) {
-        return hsm_transition(hsm, hsm->initial, NULL, NULL);
+    for (const hsm_state_t* s = target; s != entered && count < HSM_CFG_MAX_DEPTH; s = s->parent) {
+        path[count++] = s;
+    }
+    while (count > 0) {
+        prv_execute_state(hsm, path[--count], HSM_EVENT_ENTRY, hsm->async_param);
+        if (hsm->async_state != NULL) {
+            prv_async_suspend(hsm, target, hsm->async_param);
+            return;
+        }
     }
 
-    return hsm_transition(hsm, hsm->history, NULL, NULL);
+    hsm->current = target;
+    hsm->depth = target->depth;
+    hsm->in_transition = 0;
+    HSM_TRACE(hsm, HSM_TRACE_TRANSITION_END, target, HSM_EVENT_NONE);
+
+    /* Run transitions requested while entering */
+    prv_run_deferred(hsm);
 }
+#endif /* HSM_CFG_ASYNC */
+
+#if HSM_CFG_REGIONS
+/**
+ * \brief           Enter regions owned by a state that was just entered
+ * \param[in]       hsm: Pointer to HSM instance owning the regions
+ * \param[in]       owner: Entered state
+ */
+static void
+prv_regions_enter(hsm_t* hsm, const hsm_state_t* owner) {
+    for (hsm_t* r = hsm->regions; r != NULL; r = r->next_region) {
+        if (r->region_owner == owner && !r->region_active) {
+            r->current = r->initial;
+            r->depth = r->initial->depth;
+            r->region_active = 1;
+            prv_start(r);
+        }
+    }
+}
+
+/**
+ * \brief           Exit regions owned by a state that is being exited
+ *
+ * Each region exits from its current state up to the region root.
+ *
+ * \param[in]       hsm: Pointer to HSM instance owning the regions
+ * \param[in]       owner: State being exited
+ */
+static void
+prv_regions_exit(hsm_t* hsm, const hsm_state_t* owner) {
+    for (hsm_t* r = hsm->regions; r != NULL; r = r->next_region) {
+        if (r->region_owner != owner || !r->region_active) {
+            continue;
+        }
+
+        r->in_transition = 1;
+        for (const hsm_state_t* state = r->current; state != NULL; state = state->parent) {
+            prv_execute_state(r, state, HSM_EVENT_EXIT, NULL);
+        }
+        r->in_transition = 0;
+        r->deferred_count = 0;
+        r->region_active = 0;
+#if HSM_CFG_ASYNC
+        r->async_state = NULL;
+#endif /* HSM_CFG_ASYNC */
+    }
+}
+#endif /* HSM_CFG_REGIONS */
+
+/**
+ * \brief           Initialize HSM state
+ *
+ * State depth is cached from the parent and never recomputed at run time,
+ * so a parent must be created before its children. Re-creating a state
+ * that already has children leaves their depth stale, \ref hsm_validate
+ * reports it.
+ *
+ * \param[in]       state: Pointer to state structure
+ * \param[in]       name: State name
+ * \param[in]       handler: State handler function
+ * \param[in]       parent: Parent state (NULL for root), already created
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_MAX_DEPTH if `parent`
+ *                  is already at depth `HSM_CFG_MAX_DEPTH - 1`,
+ *                  \ref HSM_RES_INVALID_PARAM if `parent` was not created yet
+ */
+hsm_result_t
+hsm_state_create(hsm_state_t* state, const char* name, hsm_state_fn_t handler,
+                 const hsm_state_t* parent) {
+    /* Parent without handler is not created yet, its depth is not known */
+    if (state == NULL || handler == NULL || (parent != NULL && parent->handler == NULL)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    /* Transition paths hold up to `HSM_CFG_MAX_DEPTH` states */
+    if (parent != NULL && parent->depth + 1 >= HSM_CFG_MAX_DEPTH) {
+        return HSM_RES_MAX_DEPTH;
+    }
+
+    state->name = name;
+    state->handler = handler;
+    state->parent = parent;
+    state->depth = (parent != NULL) ? parent->depth + 1 : 0;
+#if HSM_CFG_INITIAL
+    state->initial = NULL;
+#endif /* HSM_CFG_INITIAL */
+#if HSM_CFG_STATE_HISTORY
+    state->history = HSM_HISTORY_NONE;
+    state->keeps_history = 0;
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_EVENT_MASK
+    state->events = HSM_EVENT_MASK_ALL;
+#endif /* HSM_CFG_EVENT_MASK */
+#if HSM_CFG_EVENT_DEFER
+    state->defer = 0;
+#endif /* HSM_CFG_EVENT_DEFER */
+#if HSM_CFG_GUARDS
+    state->transitions = NULL;
+    state->transition_count = 0;
+#endif /* HSM_CFG_GUARDS */
+#if HSM_CFG_EVENT_TABLE
+    state->table = NULL;
+    state->table_first = 0;
+    state->table_count = 0;
+#endif /* HSM_CFG_EVENT_TABLE */
+#if HSM_CFG_COMPILED
+    state->index = 0xFF;
+#endif /* HSM_CFG_COMPILED */
+#if PRV_STATE_SLOTS
+    state->slot = 0;
+#endif /* PRV_STATE_SLOTS */
+#if PRV_FAST_REJECT
+    prv_mask_gen++;
+#endif /* PRV_FAST_REJECT */
+#if PRV_TRACE_RING
+    {
+        uint32_t id = prv_ring_id(prv_ring_state_owners, prv_ring_state_names, &prv_ring_state_ids,
+                                  state, name);
+
+        state->id = (id < HSM_TRACE_ID_NONE) ? (uint16_t)id : HSM_TRACE_ID_NONE;
+    }
+#endif /* PRV_TRACE_RING */
+
+    return HSM_RES_OK;
+}
+
+#if HSM_CFG_EVENT_MASK
+/**
+ * \brief           Initialize HSM state with handled event mask
+ *
+ * Dispatch calls the handler only for user events set in `events`
+ * and for events outside the mask range. Other events propagate to the
+ * parent without invoking the handler. ENTRY and EXIT are always delivered.
+ *
+ * \param[in]       state: Pointer to state structure
+ * \param[in]       name: State name
+ * \param[in]       handler: State handler function
+ * \param[in]       parent: Parent state (NULL for root)
+ * \param[in]       events: Handled user events, built with \ref HSM_EVENT_BIT
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_create_ex(hsm_state_t* state, const char* name, hsm_state_fn_t handler,
+                    const hsm_state_t* parent, hsm_event_mask_t events) {
+    hsm_result_t res = hsm_state_create(state, name, handler, parent);
+
+    if (res == HSM_RES_OK) {
+        state->events = events;
+#if PRV_FAST_REJECT
+        prv_mask_gen++;
+#endif /* PRV_FAST_REJECT */
+    }
+    return res;
+}
+#endif /* HSM_CFG_EVENT_MASK */
+
+#if HSM_CFG_INITIAL
+/**
+ * \brief           Set default child of composite state
+ *
+ * Transitions targeting `state` continue into `child`, and into the
+ * default child of `child`, within one entry sequence.
+ *
+ * \param[in]       state: Composite state
+ * \param[in]       child: Direct child of `state`, `NULL` to clear
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_set_initial(hsm_state_t* state, const hsm_state_t* child) {
+    if (state == NULL || (child != NULL && child->parent != state)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    state->initial = child;
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_INITIAL */
+
+#if HSM_CFG_EVENT_DEFER
+/**
+ * \brief           Set user events postponed while state is active
+ *
+ * An event in `events` that reaches this state during dispatch is moved
+ * to the instance deferred store instead of being handled. Stored events
+ * are dispatched again, oldest first, when a state with a deferral mask
+ * is exited and the transition is complete. Deferral by a state takes
+ * precedence over handlers of its ancestors.
+ *
+ * \param[in]       state: State to configure
+ * \param[in]       events: Events to postpone, `0` to postpone none
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_set_defer(hsm_state_t* state, hsm_event_mask_t events) {
+    if (state == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    state->defer = events;
+#if PRV_FAST_REJECT
+    prv_mask_gen++;
+#endif /* PRV_FAST_REJECT */
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_GUARDS
+/**
+ * \brief           Attach declarative transitions to state
+ *
+ * On dispatch, the first transition whose event matches and whose guard
+ * passes is taken instead of calling the state handler: the machine
+ * transitions to `target` with event data as `param` and `action` as
+ * method, or only calls `action` when `target` is `NULL`. The event is
+ * consumed. Transitions use the compiled table when one is attached.
+ * Array must stay valid while the state is used.
+ *
+ * \param[in]       state: State to attach transitions to
+ * \param[in]       transitions: Transitions on user events, `NULL` to detach
+ * \param[in]       count: Number of transitions
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_set_transitions(hsm_state_t* state, const hsm_transition_t* transitions, uint8_t count) {
+    if (state == NULL || (transitions == NULL && count > 0)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+        if (transitions[i].event < HSM_EVENT_USER) {
+            return HSM_RES_INVALID_PARAM;
+        }
+    }
+
+    state->transitions = transitions;
+    state->transition_count = count;
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_GUARDS */
+
+#if HSM_CFG_EVENT_TABLE
+/**
+ * \brief           Attach dense event table to state
+ *
+ * User event `first + i` is resolved by `table[i]` with one bounds check
+ * instead of the state handler. The entry action runs first; when it
+ * returns `HSM_EVENT_NONE` (or is `NULL`), the event is consumed and the
+ * machine transitions to `target`, if set. Events outside the table and
+ * empty entries are passed to the state handler. Table must stay valid
+ * while the state is used.
+ *
+ * \param[in]       state: State to attach table to
+ * \param[in]       first: Event of first entry, at least \ref HSM_EVENT_USER
+ * \param[in]       table: Entries for events `first` to `first + count - 1`, `NULL` to detach
+ * \param[in]       count: Number of entries
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_set_table(hsm_state_t* state, hsm_event_t first, const hsm_event_entry_t* table,
+                    uint16_t count) {
+    if (state == NULL || (table != NULL && (first < HSM_EVENT_USER || count == 0))) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    state->table = table;
+    state->table_first = first;
+    state->table_count = (table != NULL) ? count : 0;
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_EVENT_TABLE */
+
+#if HSM_CFG_STATE_HISTORY
+/**
+ * \brief           Handler of history pseudo-states, never current
+ */
+static hsm_event_t
+prv_history_handler(hsm_t* hsm, hsm_event_t event, void* data) {
+    (void)hsm;
+    (void)data;
+    return event;
+}
+
+/**
+ * \brief           Create history pseudo-state of composite state
+ *
+ * The pseudo-state is only a transition target: \ref hsm_transition to it
+ * resumes `composite` where it was last exited, as one transition with a
+ * single entry sequence. The first time, `composite` itself is entered.
+ * Marks `composite` as recording its history, so it is part of the
+ * definition and must be called before instances run.
+ *
+ * History is recorded in the HSM instance, in one of
+ * \ref HSM_CFG_HISTORY_SLOTS slots per composite state, so machines sharing
+ * state structures keep separate history.
+ *
+ * \param[in]       state: Pointer to pseudo-state structure
+ * \param[in]       name: Pseudo-state name
+ * \param[in]       composite: State whose history is resumed
+ * \param[in]       kind: \ref HSM_HISTORY_SHALLOW to resume the last active direct
+ *                      child, \ref HSM_HISTORY_DEEP to resume the last active leaf
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_state_create_history(hsm_state_t* state, const char* name, hsm_state_t* composite,
+                         hsm_history_t kind) {
+    hsm_result_t res;
+
+    if (composite == NULL || (kind != HSM_HISTORY_SHALLOW && kind != HSM_HISTORY_DEEP)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    res = hsm_state_create(state, name, prv_history_handler, composite);
+    if (res == HSM_RES_OK) {
+        state->history = (uint8_t)kind;
+        composite->keeps_history = 1;
+    }
+    return res;
+}
+#endif /* HSM_CFG_STATE_HISTORY */
+
+/**
+ * \brief           Reset active configuration of HSM instance
+ *
+ * Shared by \ref hsm_init and \ref hsm_restore. Leaves what the application
+ * attached to the instance (queues, regions, callbacks, counters) untouched.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       initial_state: Initial state, becomes current state
+ */
+static void
+prv_reset_config(hsm_t* hsm, const hsm_state_t* initial_state) {
+    hsm->current = initial_state;
+    hsm->initial = initial_state;
+    hsm->depth = initial_state->depth;
+    hsm->in_transition = 0;
+    hsm->deferred_head = 0;
+    hsm->deferred_count = 0;
+
+#if HSM_CFG_HISTORY
+    hsm->history = NULL;
+#endif /* HSM_CFG_HISTORY */
+
+#if HSM_CFG_UNHANDLED && HSM_CFG_EVENT_MASK
+    hsm->reach_leaf = NULL;
+#endif /* HSM_CFG_UNHANDLED && HSM_CFG_EVENT_MASK */
+
+#if HSM_CFG_STATE_HISTORY
+    for (uint8_t i = 0; i < HSM_CFG_HISTORY_SLOTS; i++) {
+        hsm->history_slots[i].composite = NULL;
+        hsm->history_slots[i].last_active = NULL;
+    }
+#endif /* HSM_CFG_STATE_HISTORY */
+
+#if HSM_CFG_ASYNC
+    hsm->async_state = NULL;
+    hsm->async_target = NULL;
+    hsm->async_param = NULL;
+#endif /* HSM_CFG_ASYNC */
+
+#if HSM_CFG_EVENT_DEFER
+    hsm->defer_flags = 0;
+    hsm->defer_head = 0;
+    hsm->defer_count = 0;
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_REGIONS
+    hsm->region_active = 0;
+#endif /* HSM_CFG_REGIONS */
+}
+
+/**
+ * \brief           Set instance name and its trace id
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       name: HSM name
+ */
+static void
+prv_set_name(hsm_t* hsm, const char* name) {
+    hsm->name = name;
+#if PRV_TRACE_RING
+    {
+        uint32_t id = prv_ring_id(prv_ring_hsm_owners, prv_ring_hsm_names, &prv_ring_hsm_ids, hsm, name);
+
+        hsm->id = (id < 0xFF) ? (uint8_t)id : 0xFF;
+    }
+#endif /* PRV_TRACE_RING */
+}
+
+/**
+ * \brief           Reset all instance fields
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       name: HSM name
+ * \param[in]       initial_state: Initial state, becomes current state
+ */
+static void
+prv_reset(hsm_t* hsm, const char* name, const hsm_state_t* initial_state) {
+    prv_reset_config(hsm, initial_state);
+
+#if HSM_CFG_UNHANDLED
+    hsm->unhandled = NULL;
+#endif /* HSM_CFG_UNHANDLED */
+
+#if HSM_CFG_COMPILED
+    hsm->compiled = NULL;
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_QUEUE
+    hsm->queue.slots = NULL;
+    hsm->queue.mask = 0;
+    hsm->queue.head = 0;
+    hsm->queue.tail = 0;
+    hsm->queue.processing = 0;
+    hsm->queue.notify = NULL;
+    hsm->queue.notify_arg = NULL;
+#endif /* HSM_CFG_QUEUE */
+
+#if HSM_CFG_QUEUE && HSM_CFG_QUEUE_URGENT
+    hsm->urgent.slots = NULL;
+    hsm->urgent.mask = 0;
+    hsm->urgent.head = 0;
+    hsm->urgent.tail = 0;
+    hsm->urgent.processing = 0;
+    hsm->urgent.notify = NULL;
+    hsm->urgent.notify_arg = NULL;
+#endif /* HSM_CFG_QUEUE && HSM_CFG_QUEUE_URGENT */
+
+#if HSM_CFG_TIMER
+    hsm->timers = NULL;
+#endif /* HSM_CFG_TIMER */
+
+#if HSM_CFG_SCHED
+    hsm->sched_state = 0;
+    hsm->sched_home = 0;
+#endif /* HSM_CFG_SCHED */
+
+#if HSM_CFG_REGIONS
+    hsm->region_parent = NULL;
+    hsm->region_owner = NULL;
+    hsm->regions = NULL;
+    hsm->next_region = NULL;
+#endif /* HSM_CFG_REGIONS */
+
+#if PRV_TRACE_HIST
+    hsm_trace_hist_clear(&hsm->dispatch_latency);
+    hsm_trace_hist_clear(&hsm->transition_latency);
+#endif /* PRV_TRACE_HIST */
+#if HSM_CFG_STATS
+    hsm_stats_reset(hsm);
+#endif /* HSM_CFG_STATS */
+#if PRV_STATE_SLOTS
+    hsm->state_slots = NULL;
+    hsm->state_slot_count = 0;
+#endif /* PRV_STATE_SLOTS */
+
+    prv_set_name(hsm, name);
+}
+
+/**
+ * \brief           Initialize HSM instance
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       name: HSM name
+ * \param[in]       initial_state: Initial state
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_init(hsm_t* hsm, const char* name, const hsm_state_t* initial_state) {
+    if (hsm == NULL || initial_state == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    prv_reset(hsm, name, initial_state);
+    prv_start(hsm);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Check if state is part of state set
+ * \param[in]       states: State set
+ * \param[in]       count: Number of states
+ * \param[in]       state: State to find
+ * \return          `1` if found, `0` otherwise
+ */
+static uint8_t
+prv_in_set(hsm_state_t* const* states, uint16_t count, const hsm_state_t* state) {
+    for (uint16_t i = 0; i < count; i++) {
+        if (states[i] == state) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Validate a complete machine definition
+ *
+ * Checks once, before any instance runs, what the runtime assumes on
+ * every call: parents, default children and declarative targets belong
+ * to the set, parent chains end at a root within `HSM_CFG_MAX_DEPTH`
+ * levels (no cycles) and match the cached depths, default children are
+ * descendants, declarative transitions are on user events.
+ *
+ * A machine that passes can run with \ref HSM_CFG_PARAM_CHECK disabled.
+ * Reachability is not checked, transitions requested by handlers are not
+ * part of the definition; see \ref hsm_table_save_states to analyse them
+ * offline.
+ *
+ * \param[in]       states: Every state of the machine, including history pseudo-states
+ * \param[in]       count: Number of states
+ * \param[out]      failed: Index of the first offending state, can be `NULL`
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_MAX_DEPTH if nested
+ *                  too deep or cyclic, \ref HSM_RES_INVALID_PARAM otherwise
+ */
+hsm_result_t
+hsm_validate(hsm_state_t* const* states, uint16_t count, uint16_t* failed) {
+    hsm_result_t res = HSM_RES_OK;
+    uint16_t i;
+
+    if (states == NULL || count == 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (i = 0; i < count && res == HSM_RES_OK; i++) {
+        const hsm_state_t* st = states[i];
+        uint8_t levels = 1;
+
+        if (st == NULL || st->handler == NULL
+            || (st->parent != NULL && !prv_in_set(states, count, st->parent))) {
+            res = HSM_RES_INVALID_PARAM;
+            break;
+        }
+        for (const hsm_state_t* s = st->parent; s != NULL && levels <= HSM_CFG_MAX_DEPTH; s = s->parent) {
+            levels++;
+        }
+        if (levels > HSM_CFG_MAX_DEPTH) {
+            res = HSM_RES_MAX_DEPTH;
+            break;
+        }
+        /* Parent re-created after its children */
+        if (st->depth != levels - 1) {
+            res = HSM_RES_INVALID_PARAM;
+            break;
+        }
+
+#if HSM_CFG_INITIAL
+        if (st->initial != NULL) {
+            const hsm_state_t* s = st->initial->parent;
+
+            while (s != NULL && s != st) {
+                s = s->parent;
+            }
+            if (s == NULL || !prv_in_set(states, count, st->initial)) {
+                res = HSM_RES_INVALID_PARAM;
+            }
+        }
+#endif /* HSM_CFG_INITIAL */
+#if HSM_CFG_STATE_HISTORY
+        if (st->history != HSM_HISTORY_NONE && (st->parent == NULL || !st->parent->keeps_history)) {
+            res = HSM_RES_INVALID_PARAM;
+        }
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_GUARDS
+        for (uint8_t t = 0; t < st->transition_count; t++) {
+            const hsm_state_t* target = st->transitions[t].target;
+
+            if (st->transitions[t].event < HSM_EVENT_USER
+                || (target != NULL && !prv_in_set(states, count, target))) {
+                res = HSM_RES_INVALID_PARAM;
+            }
+        }
+#endif /* HSM_CFG_GUARDS */
+#if HSM_CFG_EVENT_TABLE
+        for (uint16_t e = 0; e < st->table_count; e++) {
+            if (st->table[e].target != NULL && !prv_in_set(states, count, st->table[e].target)) {
+                res = HSM_RES_INVALID_PARAM;
+            }
+        }
+#endif /* HSM_CFG_EVENT_TABLE */
+        if (res != HSM_RES_OK) {
+            break;
+        }
+    }
+
+    if (res != HSM_RES_OK && failed != NULL) {
+        *failed = i;
+    }
+    return res;
+}
+
+#if HSM_CFG_REGIONS
+/**
+ * \brief           Add orthogonal region to composite state
+ *
+ * Region is a separate HSM instance, active while `composite` is active
+ * in `hsm`. It is entered right after ENTRY of the composite, exited right
+ * before its EXIT, and sees every dispatched event before the parent's
+ * current state. An event consumed by any region is not propagated
+ * further in the parent.
+ *
+ * Regions must be added after \ref hsm_init of the owning instance, and
+ * are entered immediately when `composite` is already active.
+ *
+ * \param[in]       hsm: Pointer to owning HSM instance
+ * \param[in]       composite: State owning the region
+ * \param[in]       region: Region instance to initialize
+ * \param[in]       name: Region name
+ * \param[in]       initial_state: Initial state of the region
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_region_add(hsm_t* hsm, const hsm_state_t* composite, hsm_t* region, const char* name,
+               const hsm_state_t* initial_state) {
+    hsm_t** tail;
+
+    if (hsm == NULL || composite == NULL || region == NULL || initial_state == NULL || region == hsm) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    prv_reset(region, name, initial_state);
+    region->region_parent = hsm;
+    region->region_owner = composite;
+
+    /* Keep insertion order, regions are entered and see events in it */
+    for (tail = &hsm->regions; *tail != NULL; tail = &(*tail)->next_region) {}
+    *tail = region;
+
+    if (hsm_is_in_state(hsm, composite)) {
+        prv_regions_enter(hsm, composite);
+    }
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Get instance owning a region
+ * \param[in]       region: Pointer to region instance
+ * \return          Owning HSM instance, `NULL` when not a region
+ */
+hsm_t*
+hsm_region_get_parent(hsm_t* region) {
+    return (region != NULL) ? region->region_parent : NULL;
+}
+#endif /* HSM_CFG_REGIONS */
+
+#if HSM_CFG_ASYNC
+/**
+ * \brief           Check if an ENTRY handler is pending
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          `1` while current state waits to complete its entry, `0` otherwise
+ */
+uint8_t
+hsm_is_pending(const hsm_t* hsm) {
+    return (hsm != NULL && hsm->async_state != NULL) ? 1 : 0;
+}
+#endif /* HSM_CFG_ASYNC */
+
+#if HSM_CFG_UNHANDLED
+/**
+ * \brief           Set callback for events no state consumed
+ *
+ * Acts as a default handler above the root: it runs after the whole
+ * chain propagated the event, or instead of it when event masks show
+ * that no active state handles the event. It may request a transition.
+ * Regions report their own unhandled events to their own callback.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       fn: Callback, `NULL` to remove it
+ * \return          \ref HSM_RES_OK on success, member of \ref hsm_result_t otherwise
+ */
+hsm_result_t
+hsm_set_unhandled(hsm_t* hsm, hsm_unhandled_fn_t fn) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    hsm->unhandled = fn;
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_UNHANDLED */
+
+#if HSM_CFG_STATS
+/**
+ * \brief           Read instance counters
+ *
+ * Every counter is loaded atomically, but not together with the others,
+ * a machine running on another task can advance one between two loads.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[out]      stats: Receives the counters
+ * \return          \ref HSM_RES_OK on success, member of \ref hsm_result_t otherwise
+ */
+hsm_result_t
+hsm_stats_get(const hsm_t* hsm, hsm_stats_t* stats) {
+    if (hsm == NULL || stats == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    stats->dispatches = HSM_ATOMIC_LOAD(&hsm->stats.dispatches);
+    stats->transitions = HSM_ATOMIC_LOAD(&hsm->stats.transitions);
+    stats->unhandled = HSM_ATOMIC_LOAD(&hsm->stats.unhandled);
+    stats->deferred = HSM_ATOMIC_LOAD(&hsm->stats.deferred);
+    stats->queue_max = HSM_ATOMIC_LOAD(&hsm->stats.queue_max);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Clear instance counters
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          \ref HSM_RES_OK on success, member of \ref hsm_result_t otherwise
+ */
+hsm_result_t
+hsm_stats_reset(hsm_t* hsm) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    HSM_ATOMIC_STORE(&hsm->stats.dispatches, 0);
+    HSM_ATOMIC_STORE(&hsm->stats.transitions, 0);
+    HSM_ATOMIC_STORE(&hsm->stats.unhandled, 0);
+    HSM_ATOMIC_STORE(&hsm->stats.deferred, 0);
+    HSM_ATOMIC_STORE(&hsm->stats.queue_max, 0);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Read counters of a state in one instance
+ *
+ * Same consistency rules as \ref hsm_stats_get apply.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State recorded with \ref hsm_set_state_slots
+ * \param[out]      stats: Receives the counters
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_INVALID_PARAM
+ *                  if the instance does not record `state`
+ */
+hsm_result_t
+hsm_state_stats_get(const hsm_t* hsm, const hsm_state_t* state, hsm_state_stats_t* stats) {
+    const hsm_state_slot_t* slot;
+
+    if (hsm == NULL || state == NULL || stats == NULL || (slot = prv_state_slot(hsm, state)) == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    stats->entries = HSM_ATOMIC_LOAD(&slot->stats.entries);
+    stats->exits = HSM_ATOMIC_LOAD(&slot->stats.exits);
+    stats->handled = HSM_ATOMIC_LOAD(&slot->stats.handled);
+    stats->propagated = HSM_ATOMIC_LOAD(&slot->stats.propagated);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Clear counters of a state in one instance
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State recorded with \ref hsm_set_state_slots
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_INVALID_PARAM
+ *                  if the instance does not record `state`
+ */
+hsm_result_t
+hsm_state_stats_reset(hsm_t* hsm, const hsm_state_t* state) {
+    hsm_state_slot_t* slot;
+
+    if (hsm == NULL || state == NULL || (slot = prv_state_slot(hsm, state)) == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    HSM_ATOMIC_STORE(&slot->stats.entries, 0);
+    HSM_ATOMIC_STORE(&slot->stats.exits, 0);
+    HSM_ATOMIC_STORE(&slot->stats.handled, 0);
+    HSM_ATOMIC_STORE(&slot->stats.propagated, 0);
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_STATS */
+
+#if PRV_STATE_SLOTS
+/**
+ * \brief           Attach per-state records to HSM instance
+ *
+ * State counters (`HSM_CFG_STATS`) and handler latency histograms
+ * (`HSM_CFG_TRACE_HISTOGRAM`) are kept in `slots`, one per state of
+ * `states`, so dispatch never writes state structures and instances
+ * sharing states count separately. States outside the set are not
+ * recorded.
+ *
+ * Each state of the set is assigned its position, so updates find the
+ * record without a search. The position is part of the machine definition,
+ * like the index of \ref hsm_compile: a state shared by instances must be
+ * at the same position in each of their sets, and its first attach must
+ * happen before any instance recording it runs.
+ *
+ * Call after \ref hsm_init: the initialization entry chain is not recorded.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       slots: Storage of `count` records, cleared here, `NULL` to detach
+ * \param[in]       states: States to record, `count` entries
+ * \param[in]       count: Number of states
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_INVALID_PARAM if
+ *                  a state was attached at another position of a set
+ */
+hsm_result_t
+hsm_set_state_slots(hsm_t* hsm, hsm_state_slot_t* slots, hsm_state_t* const* states, uint16_t count) {
+    if (hsm == NULL || (slots != NULL && (states == NULL || count == 0))) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    for (uint16_t i = 0; slots != NULL && i < count; i++) {
+        if (states[i] == NULL || (states[i]->slot != 0 && states[i]->slot != i + 1)) {
+            return HSM_RES_INVALID_PARAM;
+        }
+    }
+
+    /* Detach first, so no update lands in a record being cleared */
+    hsm->state_slot_count = 0;
+    for (uint16_t i = 0; slots != NULL && i < count; i++) {
+        states[i]->slot = (uint16_t)(i + 1);
+        slots[i].state = states[i];
+#if HSM_CFG_STATS
+        slots[i].stats.entries = 0;
+        slots[i].stats.exits = 0;
+        slots[i].stats.handled = 0;
+        slots[i].stats.propagated = 0;
+#endif /* HSM_CFG_STATS */
+#if PRV_TRACE_HIST
+        hsm_trace_hist_clear(&slots[i].latency);
+#endif /* PRV_TRACE_HIST */
+    }
+    hsm->state_slots = slots;
+    hsm->state_slot_count = (slots != NULL) ? count : 0;
+    return HSM_RES_OK;
+}
+#endif /* PRV_STATE_SLOTS */
+
+/**
+ * \brief           Get current state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          Pointer to current state
+ */
+const hsm_state_t*
+hsm_get_current_state(const hsm_t* hsm) {
+    return (hsm != NULL) ? hsm->current : NULL;
+}
+
+/**
+ * \brief           Check if in specific state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State to check
+ * \return          1 if in state or parent, 0 otherwise
+ */
+uint8_t
+hsm_is_in_state(const hsm_t* hsm, const hsm_state_t* state) {
+    const hsm_state_t* current;
+
+    if (hsm == NULL || state == NULL) {
+        return 0;
+    }
+
+    current = hsm->current;
+    while (current != NULL) {
+        if (current == state) {
+            return 1;
+        }
+        current = current->parent;
+    }
+
+    return 0;
+}
+
+#if HSM_CFG_EVENT_DEFER
+static void prv_defer_recall(hsm_t* hsm);
+
+/**
+ * \brief           Move event to deferred store
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event to store
+ * \param[in]       data: Event data
+ * \return          `1` if stored, `0` if store is full
+ */
+static uint8_t
+prv_defer_store(hsm_t* hsm, hsm_event_t event, void* data) {
+    hsm_batch_event_t* e;
+
+    if (hsm->defer_count >= HSM_CFG_EVENT_DEFER_SIZE) {
+        return 0;
+    }
+    e = &hsm->defer_store[(hsm->defer_head + hsm->defer_count) % HSM_CFG_EVENT_DEFER_SIZE];
+    e->event = event;
+    e->data = data;
+    hsm->defer_count++;
+#if HSM_CFG_EVENT_POOL
+    /* Store keeps payload alive past the queue reference */
+    hsm_event_ref(data);
+#endif /* HSM_CFG_EVENT_POOL */
+    return 1;
+}
+#endif /* HSM_CFG_EVENT_DEFER */
+
+/**
+ * \brief           Account for an event no state consumed
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Unhandled event
+ * \param[in]       data: Event data
+ */
+static inline void
+prv_unhandled(hsm_t* hsm, hsm_event_t event, void* data) {
+    (void)hsm;
+    (void)event;
+    (void)data;
+    PRV_STAT_INC(hsm->stats.unhandled);
+#if HSM_CFG_UNHANDLED
+    if (hsm->unhandled != NULL) {
+        hsm->unhandled(hsm, event, data);
+    }
+#endif /* HSM_CFG_UNHANDLED */
+}
+
+#if PRV_FAST_REJECT
+/**
+ * \brief           Check if any state of the active chain handles or defers event
+ *
+ * Union of the chain masks is computed once per current state and
+ * kept until the machine leaves it or a state definition changes.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: User event within mask range
+ * \return          `1` if a handler may consume the event, `0` otherwise
+ */
+static inline uint8_t
+prv_reaches(hsm_t* hsm, hsm_event_t event) {
+    if (hsm->reach_leaf != hsm->current || hsm->reach_gen != prv_mask_gen) {
+        hsm_event_mask_t mask = 0;
+
+        for (const hsm_state_t* s = hsm->current; s != NULL; s = s->parent) {
+            mask |= s->events;
+#if HSM_CFG_EVENT_DEFER
+            mask |= s->defer;
+#endif /* HSM_CFG_EVENT_DEFER */
+        }
+        hsm->reach = mask;
+        hsm->reach_leaf = hsm->current;
+        hsm->reach_gen = prv_mask_gen;
+    }
+    return (hsm->reach & HSM_EVENT_BIT(event)) != 0;
+}
+#endif /* PRV_FAST_REJECT */
+
+#if HSM_CFG_ASYNC
+/**
+ * \brief           Deliver event to handler of a pending ENTRY
+ *
+ * Handler returns `HSM_EVENT_PENDING` to keep waiting, `HSM_EVENT_NONE`
+ * to complete the entry, or the event to leave it alone. Events left
+ * alone are kept in the deferred store when available, dropped otherwise.
+ *
+ * \param[in]       hsm: Pointer to HSM instance, `async_state` set
+ * \param[in]       event: Event to deliver
+ * \param[in]       data: Event data
+ * \return          \ref HSM_EVENT_NONE when consumed, unhandled event otherwise
+ */
+static hsm_event_t
+prv_async_dispatch(hsm_t* hsm, hsm_event_t event, void* data) {
+    hsm_event_t evt;
+
+    HSM_TRACE(hsm, HSM_TRACE_HANDLER, hsm->async_state, event);
+    evt = prv_call_handler(hsm, hsm->async_state, event, data);
+    if (evt == HSM_EVENT_PENDING) {
+        return HSM_EVENT_NONE;
+    }
+    if (evt == HSM_EVENT_NONE) {
+        prv_async_resume(hsm);
+#if HSM_CFG_EVENT_DEFER
+        /* Events postponed during the wait are due now */
+        if (hsm->defer_count > 0 && hsm->async_state == NULL) {
+            hsm->defer_flags |= PRV_DEFER_RECALL;
+            if ((hsm->defer_flags & PRV_DEFER_BUSY) == 0) {
+                prv_defer_recall(hsm);
+            }
+        }
+#endif /* HSM_CFG_EVENT_DEFER */
+        return HSM_EVENT_NONE;
+    }
+#if HSM_CFG_EVENT_DEFER
+    if (prv_defer_store(hsm, event, data)) {
+        return HSM_EVENT_NONE;
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+    return event;
+}
+#endif /* HSM_CFG_ASYNC */
+
+/**
+ * \brief           Dispatch event to current state, no parameter checks
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
+ * \return          \ref HSM_EVENT_NONE when consumed, unhandled event otherwise
+ */
+static inline hsm_event_t
+prv_dispatch(hsm_t* hsm, hsm_event_t event, void* data) {
+    const hsm_state_t* state;
+    hsm_event_t evt;
+#if HSM_CFG_EVENT_DEFER
+    uint8_t nested = hsm->defer_flags & PRV_DEFER_BUSY;
+#endif /* HSM_CFG_EVENT_DEFER */
+#if PRV_TRACE_HIST
+    uint32_t start = HSM_PORT_CYCLES();
+#endif /* PRV_TRACE_HIST */
+
+    PRV_STAT_INC(hsm->stats.dispatches);
+#if HSM_CFG_ASYNC
+    /* Waiting ENTRY handler sees events first, regions and ancestors wait */
+    if (hsm->async_state != NULL) {
+        evt = prv_async_dispatch(hsm, event, data);
+        if (evt != HSM_EVENT_NONE) {
+            prv_unhandled(hsm, evt, data);
+        }
+        return evt;
+    }
+#endif /* HSM_CFG_ASYNC */
+#if PRV_FAST_REJECT
+    /* Regions have their own chains, owner cannot reject for them */
+    if (PRV_EVENT_IN_MASK(event) && !prv_reaches(hsm, event)
+#if HSM_CFG_REGIONS
+        && hsm->regions == NULL
+#endif /* HSM_CFG_REGIONS */
+    ) {
+        prv_unhandled(hsm, event, data);
+        return event;
+    }
+#endif /* PRV_FAST_REJECT */
+
+    state = hsm->current;
+    evt = event;
+    HSM_TRACE(hsm, HSM_TRACE_DISPATCH_BEGIN, state, event);
+#if HSM_CFG_EVENT_DEFER
+    hsm->defer_flags |= PRV_DEFER_BUSY;
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_REGIONS
+    /* Active regions see the event first, in the order they were added */
+    {
+        uint8_t consumed = 0;
+
+        for (hsm_t* r = hsm->regions; r != NULL; r = r->next_region) {
+            if (!r->region_active) {
+                continue;
+            }
+            if (prv_dispatch(r, event, data) == HSM_EVENT_NONE) {
+                consumed = 1;
+            }
+            if (hsm->current != state) {
+                /* Region left its composite, remaining regions are stale */
+                consumed = 1;
+                break;
+            }
+        }
+        if (consumed) {
+            evt = HSM_EVENT_NONE;
+        }
+    }
+#endif /* HSM_CFG_REGIONS */
+
+    /* Propagate event up the state hierarchy */
+    while (state != NULL && evt != HSM_EVENT_NONE) {
+#if HSM_CFG_EVENT_DEFER
+        /* Innermost deferring state postpones event, unless store is full */
+        if ((state->defer & (PRV_EVENT_IN_MASK(evt) ? HSM_EVENT_BIT(evt) : 0)) != 0
+            && prv_defer_store(hsm, evt, data)) {
+            evt = HSM_EVENT_NONE;
+            break;
+        }
+#endif /* HSM_CFG_EVENT_DEFER */
+#if HSM_CFG_EVENT_MASK
+        /* Skip states not interested in the event */
+        if (PRV_EVENT_IN_MASK(evt) && (state->events & HSM_EVENT_BIT(evt)) == 0) {
+            state = state->parent;
+            continue;
+        }
+#endif /* HSM_CFG_EVENT_MASK */
+        HSM_TRACE(hsm, HSM_TRACE_HANDLER, state, evt);
+        evt = prv_call_handler(hsm, state, evt, data);
+#if HSM_CFG_STATS
+        {
+            hsm_state_slot_t* slot = prv_state_slot(hsm, state);
+
+            if (slot != NULL) {
+                PRV_STAT_INC(*(evt == HSM_EVENT_NONE ? &slot->stats.handled : &slot->stats.propagated));
+            }
+        }
+#endif /* HSM_CFG_STATS */
+        state = state->parent;
+    }
+    if (evt != HSM_EVENT_NONE) {
+        prv_unhandled(hsm, evt, data);
+    }
+
+    HSM_TRACE(hsm, HSM_TRACE_DISPATCH_END, hsm->current, event);
+#if PRV_TRACE_HIST
+    prv_hist_add(&hsm->dispatch_latency, start);
+#endif /* PRV_TRACE_HIST */
+#if HSM_CFG_EVENT_DEFER
+    /* Outermost dispatch recalls, after the whole chain has seen the event */
+    if (!nested) {
+        hsm->defer_flags &= ~PRV_DEFER_BUSY;
+        if (hsm->defer_flags & PRV_DEFER_RECALL) {
+            prv_defer_recall(hsm);
+        }
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+    return evt;
+}
+
+#if HSM_CFG_EVENT_DEFER
+/**
+ * \brief           Dispatch deferred events again
+ *
+ * Events deferred again by the new configuration stay in the store,
+ * in their original order, until the next recall.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ */
+static void
+prv_defer_recall(hsm_t* hsm) {
+    hsm_batch_event_t e;
+
+    hsm->defer_flags |= PRV_DEFER_BUSY;
+    while (hsm->defer_flags & PRV_DEFER_RECALL) {
+        hsm->defer_flags &= ~PRV_DEFER_RECALL;
+        for (uint8_t n = hsm->defer_count; n > 0 && hsm->defer_count > 0; --n) {
+            e = hsm->defer_store[hsm->defer_head];
+            hsm->defer_head = (hsm->defer_head + 1) % HSM_CFG_EVENT_DEFER_SIZE;
+            hsm->defer_count--;
+            prv_dispatch(hsm, e.event, e.data);
+#if HSM_CFG_EVENT_POOL
+            hsm_event_release(e.data);
+#endif /* HSM_CFG_EVENT_POOL */
+        }
+    }
+    hsm->defer_flags &= ~PRV_DEFER_BUSY;
+}
+#endif /* HSM_CFG_EVENT_DEFER */
+
+/**
+ * \brief           Dispatch event to current state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_UNHANDLED when no state
+ *                  consumed the event (with \ref HSM_CFG_UNHANDLED)
+ */
+hsm_result_t
+hsm_dispatch(hsm_t* hsm, hsm_event_t event, void* data) {
+#if HSM_CFG_PARAM_CHECK
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#endif /* HSM_CFG_PARAM_CHECK */
+
+#if HSM_CFG_UNHANDLED
+    return prv_dispatch(hsm, event, data) == HSM_EVENT_NONE ? HSM_RES_OK : HSM_RES_UNHANDLED;
+#else
+    prv_dispatch(hsm, event, data);
+    return HSM_RES_OK;
+#endif /* HSM_CFG_UNHANDLED */
+}
+
+/**
+ * \brief           Dispatch array of events in order
+ *
+ * Same as calling \ref hsm_dispatch for every entry: each event, including
+ * the transitions it triggers, runs to completion before the next one.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       events: Events with their data
+ * \param[in]       count: Number of entries in `events`
+ * \param[in]       stop: Stop after the event that leaves the machine in this
+ *                      state or one of its substates, `NULL` to dispatch all
+ * \return          Number of events dispatched, `count` if stop state was not reached
+ */
+uint32_t
+hsm_dispatch_batch(hsm_t* hsm, const hsm_batch_event_t* events, uint32_t count, const hsm_state_t* stop) {
+    uint32_t i;
+
+#if HSM_CFG_PARAM_CHECK
+    if (hsm == NULL || events == NULL) {
+        return 0;
+    }
+#endif /* HSM_CFG_PARAM_CHECK */
+
+    for (i = 0; i < count; i++) {
+        prv_dispatch(hsm, events[i].event, events[i].data);
+        if (stop != NULL && hsm_is_in_state(hsm, stop)) {
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * \brief           Dispatch one event to array of HSM instances
+ *
+ * Instances are dispatched in array order, each to completion.
+ *
+ * \param[in]       hsms: HSM instances
+ * \param[in]       count: Number of entries in `hsms`
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data, shared by all instances
+ * \return          Number of instances dispatched, stops at the first `NULL` entry
+ *                  unless \ref HSM_CFG_PARAM_CHECK is disabled
+ */
+uint32_t
+hsm_dispatch_fanout(hsm_t* const* hsms, uint32_t count, hsm_event_t event, void* data) {
+    uint32_t i;
+
+#if HSM_CFG_PARAM_CHECK
+    if (hsms == NULL) {
+        return 0;
+    }
+#endif /* HSM_CFG_PARAM_CHECK */
+
+    for (i = 0; i < count; i++) {
+#if HSM_CFG_PARAM_CHECK
+        if (hsms[i] == NULL) {
+            return i;
+        }
+#endif /* HSM_CFG_PARAM_CHECK */
+        prv_dispatch(hsms[i], event, data);
+    }
+    return count;
+}
+
+/**
+ * \brief           Transition to target state
+ *
+ * When called from an ENTRY or EXIT handler, the transition is queued and
+ * executed after the running transition completes.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       target: Target state
+ * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
+ * \param[in]       method: Optional hook function called between EXIT and ENTRY
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if deferred
+ *                  transition queue is full, \ref HSM_RES_MAX_DEPTH if the exit or
+ *                  entry path does not fit `HSM_CFG_MAX_DEPTH`; the machine stays
+ *                  in its current state. Deferred transitions aborted this way are
+ *                  reported with \ref HSM_TRACE_TRANSITION_ABORT.
+ */
+hsm_result_t
+hsm_transition(hsm_t* hsm, const hsm_state_t* target, void* param,
+               void (*method)(hsm_t* hsm, void* param)) {
+    hsm_deferred_t* d;
+
+#if HSM_CFG_PARAM_CHECK
+    if (hsm == NULL || target == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#endif /* HSM_CFG_PARAM_CHECK */
+
+    /* If already in transition, defer this transition */
+    if (hsm->in_transition) {
+        if (hsm->deferred_count >= HSM_CFG_DEFER_SIZE) {
+            return HSM_RES_FULL;
+        }
+        HSM_TRACE(hsm, HSM_TRACE_DEFERRED, target, HSM_EVENT_NONE);
+        PRV_STAT_INC(hsm->stats.deferred);
+        d = &hsm->deferred[(hsm->deferred_head + hsm->deferred_count) % HSM_CFG_DEFER_SIZE];
+        d->target = target;
+        d->param = param;
+        d->method = method;
+        hsm->deferred_count++;
+        return HSM_RES_OK;
+    }
+
+    if (prv_transition(hsm, target, param, method) != HSM_RES_OK) {
+        return HSM_RES_MAX_DEPTH;
+    }
+    prv_run_deferred(hsm);
+#if HSM_CFG_EVENT_DEFER
+    /* Transition outside of dispatch, recall here */
+    if (hsm->defer_flags == PRV_DEFER_RECALL) {
+        prv_defer_recall(hsm);
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+    return HSM_RES_OK;
+}
+
+#if HSM_CFG_HISTORY
+/**
+ * \brief           Transition to history state
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_transition_history(hsm_t* hsm) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    if (hsm->history == NULL) {
+        return hsm_transition(hsm, hsm->initial, NULL, NULL);
+    }
+
+    return hsm_transition(hsm, hsm->history, NULL, NULL);
+}
+#endif /* HSM_CFG_HISTORY */
+
+#if HSM_CFG_COMPILED
+/**
+ * \brief           Precompute transition table for a set of states
+ *
+ * Part of the machine definition, like \ref hsm_state_create: each state
+ * of the set is assigned its position as index, before any instance runs.
+ * A state belongs to at most one compiled set. Ancestors of the states do
+ * not need to be part of the set. States must not be re-parented after
+ * compilation.
+ *
+ * \param[out]      compiled: Compiled table to fill
+ * \param[in]       states: Array of `count` states
+ * \param[in]       count: Number of states, up to `255`
+ * \param[out]      paths: Storage of \ref HSM_COMPILED_PATHS_SIZE entries
+ * \param[out]      table: Storage of \ref HSM_COMPILED_TABLE_SIZE entries
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_MAX_DEPTH
+ *                  if a state is nested deeper than `HSM_CFG_MAX_DEPTH`,
+ *                  \ref HSM_RES_INVALID_PARAM if a cached depth is stale or a
+ *                  state was compiled at another position of a set
+ */
+hsm_result_t
+hsm_compile(hsm_compiled_t* compiled, hsm_state_t* const* states, uint8_t count,
+            const hsm_state_t** paths, uint8_t* table) {
+    uint8_t i, j, k, len;
+
+    if (compiled == NULL || states == NULL || count == 0 || count == 0xFF || paths == NULL || table == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    /* Build root-first ancestor path of each state */
+    for (i = 0; i < count; i++) {
+        const hsm_state_t** path = &paths[i * HSM_CFG_MAX_DEPTH];
+
+        /* Index is shared by every instance, it cannot serve two sets */
+        if (states[i] == NULL || (states[i]->index != 0xFF && states[i]->index != i)) {
+            return HSM_RES_INVALID_PARAM;
+        }
+        len = states[i]->depth + 1;
+        if (len > HSM_CFG_MAX_DEPTH) {
+            return HSM_RES_MAX_DEPTH;
+        }
+        k = len;
+        for (const hsm_state_t* state = states[i]; state != NULL; state = state->parent) {
+            /* Chain longer than cached depth, parent re-created after its children */
+            if (k == 0) {
+                return HSM_RES_INVALID_PARAM;
+            }
+            path[--k] = state;
+        }
+        if (k != 0) {
+            return HSM_RES_INVALID_PARAM;
+        }
+        table[i * count + i] = len;
+        states[i]->index = i;
+    }
+
+    /* Shared path prefix of every pair */
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < count; j++) {
+            uint8_t len_i = table[i * count + i];
+            uint8_t len_j = table[j * count + j];
+
+            if (i == j) {
+                continue;
+            }
+            for (k = 0; k < len_i && k < len_j; k++) {
+                if (paths[i * HSM_CFG_MAX_DEPTH + k] != paths[j * HSM_CFG_MAX_DEPTH + k]) {
+                    break;
+                }
+            }
+            table[i * count + j] = k;
+        }
+    }
+
+    compiled->states = states;
+    compiled->paths = paths;
+    compiled->table = table;
+    compiled->count = count;
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Attach compiled transition table to HSM instance
+ *
+ * Transitions between states of the compiled set use the table,
+ * other transitions use the dynamic path. One table can be shared
+ * by many HSM instances.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       compiled: Compiled table, or `NULL` to detach
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_set_compiled(hsm_t* hsm, const hsm_compiled_t* compiled) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    hsm->compiled = compiled;
+
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_QUEUE
+/**
+ * \brief           Take oldest event from the queue
+ * \note            Must only be called by the consumer of the queue
+ * \param[in]       q: Pointer to queue
+ * \param[out]      event: Dequeued event
+ * \param[out]      data: Dequeued event data
+ * \return          `1` if event was dequeued, `0` if queue is empty
+ */
+static uint8_t
+prv_queue_pop(hsm_queue_t* q, hsm_event_t* event, void** data) {
+    uint32_t pos = q->tail;
+    hsm_queue_slot_t* slot = &q->slots[pos & q->mask];
+
+    /* Slot is ready once its producer published `pos + 1` */
+    if ((int32_t)(HSM_ATOMIC_LOAD(&slot->seq) - (pos + 1)) < 0) {
+        return 0;
+    }
+    *event = slot->event;
+    *data = slot->data;
+
+    /* Release slot for the producer one lap ahead */
+    HSM_ATOMIC_STORE(&slot->seq, pos + q->mask + 1);
+    q->tail = pos + 1;
+    return 1;
+}
+
+/**
+ * \brief           Reset queue to empty and assign its storage
+ * \param[in]       q: Pointer to queue
+ * \param[in]       slots: Slot storage
+ * \param[in]       size: Number of slots, must be a power of two
+ * \return          \ref HSM_RES_OK on success
+ */
+static hsm_result_t
+prv_queue_setup(hsm_queue_t* q, hsm_queue_slot_t* slots, uint32_t size) {
+    uint32_t i;
+
+    if (slots == NULL || size < 2 || (size & (size - 1)) != 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (i = 0; i < size; i++) {
+        slots[i].seq = i;
+        slots[i].event = HSM_EVENT_NONE;
+        slots[i].data = NULL;
+    }
+    q->mask = size - 1;
+    q->head = 0;
+    q->tail = 0;
+    q->processing = 0;
+    HSM_ATOMIC_STORE(&q->slots, slots);
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Add event to queue, lock-free for concurrent producers
+ * \param[in]       hsm: Pointer to HSM instance owning the queue
+ * \param[in]       q: Pointer to queue
+ * \param[in]       event: Event to add
+ * \param[in]       data: Event data
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if queue is full,
+ *                  \ref HSM_RES_ERROR if queue was not initialized
+ */
+static hsm_result_t
+prv_queue_push(hsm_t* hsm, hsm_queue_t* q, hsm_event_t event, void* data) {
+    hsm_queue_slot_t* slot;
+    uint32_t pos;
+    int32_t diff;
+
+    if (HSM_ATOMIC_LOAD(&q->slots) == NULL) {
+        return HSM_RES_ERROR;
+    }
+
+    /* Claim a free slot by advancing the shared head */
+    pos = HSM_ATOMIC_LOAD(&q->head);
+    for (;;) {
+        slot = &q->slots[pos & q->mask];
+        diff = (int32_t)(HSM_ATOMIC_LOAD(&slot->seq) - pos);
+        if (diff == 0) {
+            if (HSM_ATOMIC_CAS(&q->head, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return HSM_RES_FULL;
+        } else {
+            pos = HSM_ATOMIC_LOAD(&q->head);
+        }
+    }
+
+    /* Fill slot and publish it to the consumer */
+    slot->event = event;
+    slot->data = data;
+    HSM_ATOMIC_STORE(&slot->seq, pos + 1);
+#if HSM_CFG_STATS
+    {
+        /* Consumer may already be past this slot, depth is then negative */
+        int32_t depth = (int32_t)(pos + 1 - HSM_ATOMIC_LOAD(&q->tail));
+        uint32_t max = HSM_ATOMIC_LOAD(&hsm->stats.queue_max);
+
+        /* Producers race, keep the largest */
+        while (depth > 0 && (uint32_t)depth > max
+               && !HSM_ATOMIC_CAS(&hsm->stats.queue_max, &max, (uint32_t)depth)) {}
+    }
+#endif /* HSM_CFG_STATS */
+
+    /* Urgent lane without its own notification wakes the queue consumer */
+    if (q->notify == NULL) {
+        q = &hsm->queue;
+    }
+    if (q->notify != NULL) {
+        q->notify(hsm, q->notify_arg);
+    }
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Assign event queue storage to HSM instance
+ * \note            Call after \ref hsm_init and before the first \ref hsm_post
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       slots: Slot storage, must remain valid for HSM lifetime
+ * \param[in]       size: Number of slots, must be a power of two
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_queue_init(hsm_t* hsm, hsm_queue_slot_t* slots, uint32_t size) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    return prv_queue_setup(&hsm->queue, slots, size);
+}
+
+/**
+ * \brief           Post event to HSM queue
+ *
+ * Lock-free and safe to call concurrently from any task, core or ISR.
+ * The event is dispatched later by \ref hsm_process.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event to post
+ * \param[in]       data: Event data, must remain valid until dispatched.
+ *                      With `HSM_CFG_EVENT_POOL`, the queue takes over the caller's
+ *                      reference of pool payloads on success.
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if queue is full,
+ *                  \ref HSM_RES_ERROR if queue was not initialized
+ */
+hsm_result_t
+hsm_post(hsm_t* hsm, hsm_event_t event, void* data) {
+    if (hsm == NULL || event == HSM_EVENT_NONE) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    return prv_queue_push(hsm, &hsm->queue, event, data);
+}
+
+#if HSM_CFG_QUEUE_URGENT
+/**
+ * \brief           Assign urgent lane storage to HSM instance
+ *
+ * Events of the urgent lane are dispatched before any event waiting in the
+ * normal queue. The normal queue must be initialized too.
+ *
+ * \note            Call after \ref hsm_init and before the first \ref hsm_post_urgent
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       slots: Slot storage, must remain valid for HSM lifetime
+ * \param[in]       size: Number of slots, must be a power of two
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_queue_init_urgent(hsm_t* hsm, hsm_queue_slot_t* slots, uint32_t size) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    return prv_queue_setup(&hsm->urgent, slots, size);
+}
+
+/**
+ * \brief           Post event to urgent lane of HSM queue
+ *
+ * Same rules as \ref hsm_post. The event overtakes every event waiting in
+ * the normal queue, but does not preempt the event being dispatched.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event to post
+ * \param[in]       data: Event data, see \ref hsm_post
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if lane is full,
+ *                  \ref HSM_RES_ERROR if lane was not initialized
+ */
+hsm_result_t
+hsm_post_urgent(hsm_t* hsm, hsm_event_t event, void* data) {
+    if (hsm == NULL || event == HSM_EVENT_NONE) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    return prv_queue_push(hsm, &hsm->urgent, event, data);
+}
+
+/**
+ * \brief           Set function called after every successful \ref hsm_post_urgent
+ *
+ * Same rules as \ref hsm_queue_set_notify. Without it, urgent posts call
+ * the notification of the normal queue, so one function wakes the
+ * consumer of both lanes.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       notify: Notification function, `NULL` to use the one of the normal queue
+ * \param[in]       arg: User argument passed to `notify`
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_queue_set_notify_urgent(hsm_t* hsm, void (*notify)(hsm_t* hsm, void* arg), void* arg) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    hsm->urgent.notify = notify;
+    hsm->urgent.notify_arg = arg;
+
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_QUEUE_URGENT */
+
+/**
+ * \brief           Dispatch queued events, up to a limit
+ *
+ * Each event runs to completion, including deferred transitions,
+ * before the next one is taken. Must be called only from the task owning
+ * the HSM. Calls made from within a state handler return immediately,
+ * events posted meanwhile are picked up by the outer call.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       max: Maximum number of events to dispatch
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_process_max(hsm_t* hsm, uint32_t max) {
+    hsm_event_t event;
+    void* data;
+    uint32_t count = 0;
+
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    if (hsm->queue.slots == NULL) {
+        return HSM_RES_ERROR;
+    }
+    if (hsm->queue.processing) {
+        return HSM_RES_OK;
+    }
+
+    hsm->queue.processing = 1;
+    while (count < max
+#if HSM_CFG_QUEUE_URGENT
+           && ((hsm->urgent.slots != NULL && prv_queue_pop(&hsm->urgent, &event, &data))
+               || prv_queue_pop(&hsm->queue, &event, &data))) {
+#else
+           && prv_queue_pop(&hsm->queue, &event, &data)) {
+#endif /* HSM_CFG_QUEUE_URGENT */
+        prv_dispatch(hsm, event, data);
+#if HSM_CFG_EVENT_POOL
+        /* Queue reference is dropped once the whole chain has seen the event */
+        hsm_event_release(data);
+#endif /* HSM_CFG_EVENT_POOL */
+        count++;
+    }
+    hsm->queue.processing = 0;
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Dispatch all queued events
+ * \note            See \ref hsm_process_max for run-to-completion rules
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_process(hsm_t* hsm) {
+    return hsm_process_max(hsm, 0xFFFFFFFFUL);
+}
+
+/**
+ * \brief           Check if events are waiting in HSM queue
+ * \note            Must only be called by the consumer of the queue
+ * \param[in]       hsm: Pointer to HSM instance
+ * \return          `1` if at least one event is ready, `0` otherwise
+ */
+uint8_t
+hsm_queue_pending(const hsm_t* hsm) {
+    const hsm_queue_t* q;
+
+    if (hsm == NULL || hsm->queue.slots == NULL) {
+        return 0;
+    }
+#if HSM_CFG_QUEUE_URGENT
+    q = &hsm->urgent;
+    if (q->slots != NULL
+        && (int32_t)(HSM_ATOMIC_LOAD(&q->slots[q->tail & q->mask].seq) - (q->tail + 1)) >= 0) {
+        return 1;
+    }
+#endif /* HSM_CFG_QUEUE_URGENT */
+    q = &hsm->queue;
+    return (int32_t)(HSM_ATOMIC_LOAD(&q->slots[q->tail & q->mask].seq) - (q->tail + 1)) >= 0;
+}
+
+/**
+ * \brief           Set function called after every successful \ref hsm_post
+ *
+ * Runs in the context of the poster, so it must be ISR safe if events
+ * are posted from ISR. Typically wakes the task owning the HSM.
+ * Set it before events are posted.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       notify: Notification function, `NULL` to disable
+ * \param[in]       arg: User argument passed to `notify`
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_queue_set_notify(hsm_t* hsm, void (*notify)(hsm_t* hsm, void* arg), void* arg) {
+    if (hsm == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    hsm->queue.notify = notify;
+    hsm->queue.notify_arg = arg;
+
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_QUEUE */
+
+#if HSM_CFG_EVENT_POOL
+#if !HSM_CFG_EVENT_POOL_SMALL && !HSM_CFG_EVENT_POOL_MEDIUM && !HSM_CFG_EVENT_POOL_LARGE
+#error "HSM_CFG_EVENT_POOL requires at least one enabled size class"
+#endif
+
+/* Block header, keeps payload 8-byte aligned */
+#define PRV_POOL_HDR_WORDS       1
+#define PRV_POOL_WORDS(size)     (PRV_POOL_HDR_WORDS + ((size) + 7) / 8)
+#define PRV_POOL_MAP_WORDS       ((HSM_CFG_EVENT_POOL_SIZE + 31) / 32)
+
+/**
+ * \brief           Event pool size class descriptor
+ */
+typedef struct {
+    uint64_t* storage;                        /*!< Block storage */
+    uint32_t* used;                           /*!< Used block bitmap */
+    uint32_t words;                           /*!< Block stride in 64-bit words */
+    uint32_t size;                            /*!< Payload size in bytes */
+} prv_pool_class_t;
+
+#if HSM_CFG_EVENT_POOL_SMALL
+static uint64_t prv_pool_small[HSM_CFG_EVENT_POOL_SIZE * PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_SMALL)];
+static uint32_t prv_pool_small_used[PRV_POOL_MAP_WORDS];
+#endif /* HSM_CFG_EVENT_POOL_SMALL */
+#if HSM_CFG_EVENT_POOL_MEDIUM
+static uint64_t prv_pool_medium[HSM_CFG_EVENT_POOL_SIZE * PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_MEDIUM)];
+static uint32_t prv_pool_medium_used[PRV_POOL_MAP_WORDS];
+#endif /* HSM_CFG_EVENT_POOL_MEDIUM */
+#if HSM_CFG_EVENT_POOL_LARGE
+static uint64_t prv_pool_large[HSM_CFG_EVENT_POOL_SIZE * PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_LARGE)];
+static uint32_t prv_pool_large_used[PRV_POOL_MAP_WORDS];
+#endif /* HSM_CFG_EVENT_POOL_LARGE */
+
+/* Size classes in ascending payload size */
+static const prv_pool_class_t prv_pool_classes[] = {
+#if HSM_CFG_EVENT_POOL_SMALL
+    {prv_pool_small, prv_pool_small_used, PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_SMALL), HSM_CFG_EVENT_POOL_SMALL},
+#endif /* HSM_CFG_EVENT_POOL_SMALL */
+#if HSM_CFG_EVENT_POOL_MEDIUM
+    {prv_pool_medium, prv_pool_medium_used, PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_MEDIUM), HSM_CFG_EVENT_POOL_MEDIUM},
+#endif /* HSM_CFG_EVENT_POOL_MEDIUM */
+#if HSM_CFG_EVENT_POOL_LARGE
+    {prv_pool_large, prv_pool_large_used, PRV_POOL_WORDS(HSM_CFG_EVENT_POOL_LARGE), HSM_CFG_EVENT_POOL_LARGE},
+#endif /* HSM_CFG_EVENT_POOL_LARGE */
+};
+
+#define PRV_POOL_CLASSES         (sizeof(prv_pool_classes) / sizeof(prv_pool_classes[0]))
+
+/**
+ * \brief           Find block header of pool payload
+ * \param[in]       data: Payload pointer
+ * \param[out]      cls: Size class of the block, can be `NULL`
+ * \param[out]      index: Block index within its class, can be `NULL`
+ * \return          Pointer to block reference counter, `NULL` if not a pool payload
+ */
+static uint32_t*
+prv_pool_find(const void* data, const prv_pool_class_t** cls, uint32_t* index) {
+    const uint64_t* word = (const uint64_t*)data;
+    size_t i, off;
+
+    for (i = 0; i < PRV_POOL_CLASSES; i++) {
+        const prv_pool_class_t* c = &prv_pool_classes[i];
+
+        if (word < c->storage + PRV_POOL_HDR_WORDS
+            || word >= c->storage + (size_t)HSM_CFG_EVENT_POOL_SIZE * c->words) {
+            continue;
+        }
+        off = (size_t)(word - c->storage);
+        if (off % c->words != PRV_POOL_HDR_WORDS) {
+            return NULL;
+        }
+        if (cls != NULL) {
+            *cls = c;
+        }
+        if (index != NULL) {
+            *index = (uint32_t)(off / c->words);
+        }
+        return (uint32_t*)(void*)&c->storage[off - PRV_POOL_HDR_WORDS];
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Allocate event payload from static pool
+ *
+ * Lock-free and safe to call from any task, core or ISR.
+ * The block is taken from the smallest size class that fits and is
+ * returned with one reference held by the caller.
+ *
+ * \param[in]       size: Payload size in bytes
+ * \return          Pointer to 8-byte aligned payload, `NULL` if no block is free
+ */
+void*
+hsm_event_alloc(size_t size) {
+    size_t i;
+    uint32_t w, bit, used, valid;
+
+    for (i = 0; i < PRV_POOL_CLASSES; i++) {
+        const prv_pool_class_t* c = &prv_pool_classes[i];
+
+        if (size > c->size) {
+            continue;
+        }
+        for (w = 0; w < PRV_POOL_MAP_WORDS; w++) {
+            valid = (w == PRV_POOL_MAP_WORDS - 1 && (HSM_CFG_EVENT_POOL_SIZE % 32) != 0)
+                        ? ((1UL << (HSM_CFG_EVENT_POOL_SIZE % 32)) - 1)
+                        : 0xFFFFFFFFUL;
+            used = HSM_ATOMIC_LOAD(&c->used[w]);
+            while ((~used & valid) != 0) {
+                uint32_t free_mask = ~used & valid;
+
+                /* Claim lowest free block of this word */
+                for (bit = 0; (free_mask & (1UL << bit)) == 0; bit++) {}
+                if (HSM_ATOMIC_CAS(&c->used[w], &used, used | (1UL << bit))) {
+                    uint64_t* block = &c->storage[(size_t)(w * 32 + bit) * c->words];
+
+                    HSM_ATOMIC_STORE((uint32_t*)(void*)block, 1);
+                    return block + PRV_POOL_HDR_WORDS;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Add reference to pool payload
+ *
+ * State handlers keeping a posted payload beyond dispatch take
+ * a reference and release it when done. Ignored for non-pool data.
+ *
+ * \param[in]       data: Payload pointer
+ */
+void
+hsm_event_ref(void* data) {
+    uint32_t* refs = prv_pool_find(data, NULL, NULL);
+
+    if (refs != NULL) {
+        HSM_ATOMIC_FETCH_ADD(refs, 1);
+    }
+}
+
+/**
+ * \brief           Drop reference to pool payload
+ *
+ * The block returns to the pool when the last reference is
+ * released. Ignored for non-pool data.
+ *
+ * \param[in]       data: Payload pointer
+ */
+void
+hsm_event_release(void* data) {
+    const prv_pool_class_t* c;
+    uint32_t index, used, mask;
+    uint32_t* refs = prv_pool_find(data, &c, &index);
+
+    if (refs == NULL || HSM_ATOMIC_FETCH_ADD(refs, (uint32_t)-1) != 1) {
+        return;
+    }
+
+    /* Last reference gone, mark block free */
+    mask = 1UL << (index % 32);
+    used = HSM_ATOMIC_LOAD(&c->used[index / 32]);
+    while (!HSM_ATOMIC_CAS(&c->used[index / 32], &used, used & ~mask)) {}
+}
+
+/**
+ * \brief           Check if pointer is a payload allocated from the event pool
+ * \param[in]       data: Pointer to check
+ * \return          `1` if pool payload, `0` otherwise
+ */
+uint8_t
+hsm_event_is_pooled(const void* data) {
+    return prv_pool_find(data, NULL, NULL) != NULL;
+}
+#endif /* HSM_CFG_EVENT_POOL */
+
+#if PRV_TRACE_HIST
+/**
+ * \brief           Reset latency histogram
+ * \param[in]       hist: Histogram to clear
+ */
+void
+hsm_trace_hist_clear(hsm_trace_hist_t* hist) {
+    uint8_t i;
+
+    if (hist == NULL) {
+        return;
+    }
+    for (i = 0; i < HSM_CFG_TRACE_HISTOGRAM_BINS; i++) {
+        hist->bins[i] = 0;
+    }
+}
+
+/**
+ * \brief           Get latency percentile from histogram
+ * \param[in]       hist: Histogram
+ * \param[in]       percent: Percentile, `0` to `100`
+ * \return          Upper bound in cycles of the bin holding the percentile,
+ *                  `0` if histogram is empty
+ */
+uint32_t
+hsm_trace_hist_percentile(const hsm_trace_hist_t* hist, uint8_t percent) {
+    uint64_t total = 0, rank, sum = 0;
+    uint8_t i;
+
+    if (hist == NULL) {
+        return 0;
+    }
+    for (i = 0; i < HSM_CFG_TRACE_HISTOGRAM_BINS; i++) {
+        total += hist->bins[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    rank = (total * (percent > 100 ? 100 : percent) + 99) / 100;
+    for (i = 0; i < HSM_CFG_TRACE_HISTOGRAM_BINS - 1; i++) {
+        sum += hist->bins[i];
+        if (sum >= rank && sum > 0) {
+            break;
+        }
+    }
+    return (i >= 31 || i == HSM_CFG_TRACE_HISTOGRAM_BINS - 1) ? 0xFFFFFFFFUL : ((1UL << (i + 1)) - 1);
+}
+
+/**
+ * \brief           Get handler latency histogram of a state in one instance
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       state: State recorded with \ref hsm_set_state_slots
+ * \return          Histogram, `NULL` if the instance does not record `state`
+ */
+hsm_trace_hist_t*
+hsm_state_latency(hsm_t* hsm, const hsm_state_t* state) {
+    hsm_state_slot_t* slot = (hsm != NULL) ? prv_state_slot(hsm, state) : NULL;
+
+    return (slot != NULL) ? &slot->latency : NULL;
+}
+#endif /* PRV_TRACE_HIST */
+
+#if PRV_TRACE_RING
+/**
+ * \brief           Write length-prefixed name table
+ * \param[in]       names: Name table
+ * \param[in]       count: Number of names
+ * \param[in]       write: Output function
+ * \param[in]       arg: User argument
+ */
+static void
+prv_ring_dump_names(const char* const* names, uint16_t count, hsm_trace_write_fn write, void* arg) {
+    uint16_t i, len;
+
+    for (i = 0; i < count; i++) {
+        for (len = 0; names[i] != NULL && names[i][len] != '\0' && len < 0xFFFF; len++) {}
+        write(&len, sizeof(len), arg);
+        if (len > 0) {
+            write(names[i], len, arg);
+        }
+    }
+}
+
+/**
+ * \brief           Discard all records in trace ring buffer
+ */
+void
+hsm_trace_ring_clear(void) {
+    HSM_ATOMIC_STORE(&prv_ring_head, 0);
+}
+
+/**
+ * \brief           Dump trace ring buffer in binary form
+ *
+ * Output starts with a header and the state and HSM name tables,
+ * followed by records from oldest to newest. All fields are in target
+ * byte order. Decode with `tools/hsm_trace_decode.c`.
+ *
+ * Intended for post-mortem use: records written while dumping
+ * may appear torn.
+ *
+ * \param[in]       write: Output function, called several times
+ * \param[in]       arg: User argument passed to `write`
+ */
+void
+hsm_trace_ring_dump(hsm_trace_write_fn write, void* arg) {
+    uint32_t head, count, i;
+    uint16_t state_names, hsm_names;
+    struct {
+        char magic[4];
+        uint16_t version;
+        uint16_t record_size;
+        uint16_t state_names;
+        uint16_t hsm_names;
+        uint32_t records;
+    } hdr = {{'H', 'S', 'M', 'T'}, 1, sizeof(hsm_trace_record_t), 0, 0, 0};
+
+    if (write == NULL) {
+        return;
+    }
+
+    head = HSM_ATOMIC_LOAD(&prv_ring_head);
+    count = head < HSM_CFG_TRACE_RING_SIZE ? head : HSM_CFG_TRACE_RING_SIZE;
+    state_names = (uint16_t)(prv_ring_state_ids < HSM_CFG_TRACE_RING_NAMES ? prv_ring_state_ids
+                                                                            : HSM_CFG_TRACE_RING_NAMES);
+    hsm_names = (uint16_t)(prv_ring_hsm_ids < HSM_CFG_TRACE_RING_NAMES ? prv_ring_hsm_ids
+                                                                        : HSM_CFG_TRACE_RING_NAMES);
+
+    hdr.state_names = state_names;
+    hdr.hsm_names = hsm_names;
+    hdr.records = count;
+    write(&hdr, sizeof(hdr), arg);
+    prv_ring_dump_names(prv_ring_state_names, state_names, write, arg);
+    prv_ring_dump_names(prv_ring_hsm_names, hsm_names, write, arg);
+
+    for (i = head - count; i != head; i++) {
+        write(&prv_ring[i & (HSM_CFG_TRACE_RING_SIZE - 1)], sizeof(hsm_trace_record_t), arg);
+    }
+}
+#endif /* PRV_TRACE_RING */
+
+#if HSM_CFG_SNAPSHOT
+
+#define PRV_SNAP_VERSION   2
+#define PRV_SNAP_HDR_SIZE  11
+#define PRV_SNAP_EVT_SIZE  (4 + sizeof(void*))
+#define PRV_SNAP_ID_NONE   0xFF
+
+/* Record of one instance: current, initial, history, region active flag,
+   number of regions, number of deferred events, then per-state history */
+#define PRV_SNAP_INST_SIZE(count) (6 + (HSM_CFG_STATE_HISTORY ? (count) : 0))
+
+/**
+ * \brief           FNV-1a hash of snapshot bytes
+ * \param[in]       data: Bytes to hash
+ * \param[in]       len: Number of bytes
+ * \return          Hash value
+ */
+static uint32_t
+prv_snap_hash(const uint8_t* data, size_t len) {
+    uint32_t h = 0x811C9DC5UL;
+
+    while (len-- > 0) {
+        h = (h ^ *data++) * 0x01000193UL;
+    }
+    return h;
+}
+
+/**
+ * \brief           Write little-endian 32-bit value
+ * \param[out]      p: Pointer to first byte
+ * \param[in]       v: Value
+ */
+static void
+prv_snap_put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * \brief           Read little-endian 32-bit value
+ * \param[in]       p: Pointer to first byte
+ * \return          Value
+ */
+static uint32_t
+prv_snap_get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * \brief           Get stable id of state, its position in state set
+ * \param[in]       states: State set
+ * \param[in]       count: Number of states in set
+ * \param[in]       state: State to look up, can be `NULL`
+ * \return          Position, \ref PRV_SNAP_ID_NONE for `NULL`, `count` if not in set
+ */
+static uint8_t
+prv_snap_id(hsm_state_t* const* states, uint8_t count, const hsm_state_t* state) {
+    uint8_t i;
+
+    if (state == NULL) {
+        return PRV_SNAP_ID_NONE;
+    }
+    for (i = 0; i < count; i++) {
+        if (states[i] == state) {
+            break;
+        }
+    }
+    return i;
+}
+
+#if HSM_CFG_QUEUE || HSM_CFG_EVENT_DEFER
+/**
+ * \brief           Store one event
+ * \param[out]      p: Output, \ref PRV_SNAP_EVT_SIZE bytes
+ * \param[in]       event: Event
+ * \param[in]       data: Event data
+ * \return          `1` on success, `0` for a pool payload
+ */
+static uint8_t
+prv_snap_event(uint8_t* p, hsm_event_t event, void* data) {
+#if HSM_CFG_EVENT_POOL
+    if (hsm_event_is_pooled(data)) {
+        return 0;
+    }
+#endif /* HSM_CFG_EVENT_POOL */
+    prv_snap_put_u32(p, event);
+    memcpy(&p[4], &data, sizeof(void*));
+    return 1;
+}
+#endif /* HSM_CFG_QUEUE || HSM_CFG_EVENT_DEFER */
+
+/**
+ * \brief           Store record of an instance, then of its regions
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       states: State set
+ * \param[in]       count: Number of states in set
+ * \param[out]      b: Snapshot buffer
+ * \param[in]       size: Snapshot buffer size
+ * \param[in,out]   len: Bytes used so far
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_snap_save(const hsm_t* hsm, hsm_state_t* const* states, uint8_t count, uint8_t* b, size_t size,
+              size_t* len) {
+    uint8_t* r = &b[*len];
+    uint8_t regions = 0, deferred = 0;
+
+    if (hsm->in_transition || *len + PRV_SNAP_INST_SIZE(count) + 4 > size) {
+        return 0;
+    }
+#if HSM_CFG_ASYNC
+    /* Suspended transition, cannot be resumed after restore */
+    if (hsm->async_state != NULL) {
+        return 0;
+    }
+#endif /* HSM_CFG_ASYNC */
+
+    r[0] = prv_snap_id(states, count, hsm->current);
+    r[1] = prv_snap_id(states, count, hsm->initial);
+#if HSM_CFG_HISTORY
+    r[2] = prv_snap_id(states, count, hsm->history);
+#else
+    r[2] = PRV_SNAP_ID_NONE;
+#endif /* HSM_CFG_HISTORY */
+#if HSM_CFG_REGIONS
+    r[3] = hsm->region_active;
+#else
+    r[3] = 0;
+#endif /* HSM_CFG_REGIONS */
+    if (r[0] >= count || r[1] >= count || r[2] == count) {
+        return 0;
+    }
+    *len += 6;
+
+#if HSM_CFG_STATE_HISTORY
+    /* Per-state history, same order as state set */
+    for (uint8_t i = 0; i < count; i++) {
+        b[*len] = prv_snap_id(states, count, prv_history_get(hsm, states[i]));
+        if (b[(*len)++] == count) {
+            return 0;
+        }
+    }
+#endif /* HSM_CFG_STATE_HISTORY */
+
+#if HSM_CFG_EVENT_DEFER
+    /* Deferred events, oldest first */
+    for (; deferred < hsm->defer_count; deferred++) {
+        const hsm_batch_event_t* e =
+            &hsm->defer_store[(hsm->defer_head + deferred) % HSM_CFG_EVENT_DEFER_SIZE];
+
+        if (*len + PRV_SNAP_EVT_SIZE + 4 > size || !prv_snap_event(&b[*len], e->event, e->data)) {
+            return 0;
+        }
+        *len += PRV_SNAP_EVT_SIZE;
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_REGIONS
+    for (const hsm_t* region = hsm->regions; region != NULL; region = region->next_region) {
+        if (regions == 0xFF || !prv_snap_save(region, states, count, b, size, len)) {
+            return 0;
+        }
+        regions++;
+    }
+#endif /* HSM_CFG_REGIONS */
+
+    r[4] = regions;
+    r[5] = deferred;
+    return 1;
+}
+
+#if HSM_CFG_QUEUE
+/**
+ * \brief           Store events waiting in a queue, oldest first, without consuming them
+ * \param[in]       q: Pointer to queue
+ * \param[out]      b: Snapshot buffer
+ * \param[in]       size: Snapshot buffer size
+ * \param[in,out]   len: Bytes used so far
+ * \param[out]      events: Number of events stored
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+prv_snap_queue(const hsm_queue_t* q, uint8_t* b, size_t size, size_t* len, uint16_t* events) {
+    const hsm_queue_slot_t* slot;
+
+    *events = 0;
+    if (q->slots == NULL) {
+        return 1;
+    }
+    for (uint32_t pos = q->tail;; pos++) {
+        slot = &q->slots[pos & q->mask];
+        if ((int32_t)(HSM_ATOMIC_LOAD(&slot->seq) - (pos + 1)) < 0) {
+            return 1;
+        }
+        if (*len + PRV_SNAP_EVT_SIZE + 4 > size || *events == 0xFFFF
+            || !prv_snap_event(&b[*len], slot->event, slot->data)) {
+            return 0;
+        }
+        *len += PRV_SNAP_EVT_SIZE;
+        (*events)++;
+    }
+}
+#endif /* HSM_CFG_QUEUE */
+
+/**
+ * \brief           Save active configuration of HSM instance
+ *
+ * Stores, for the instance and every region added to it, current, initial
+ * and history states as positions in `states`, so the snapshot stays valid
+ * across resets of the same firmware, plus per-state history of the set
+ * and deferred events. Then stores events waiting in the urgent lane and
+ * in the queue. No transition can be running, so the deferred transition
+ * queue is always empty at this point.
+ *
+ * Event data pointers are stored as they are and must point to memory
+ * that survives the reset; pool payloads are rejected. Armed timers are
+ * not saved, re-arm them after \ref hsm_restore.
+ *
+ * \param[in]       hsm: Pointer to HSM instance, not in a transition and not
+ *                      waiting for an asynchronous ENTRY to complete
+ * \param[in]       states: State set with every state the instance and its regions
+ *                      can be in, up to `254` entries, same order as for \ref hsm_restore
+ * \param[in]       count: Number of states in set
+ * \param[out]      buf: Output buffer, for example in retained RAM
+ * \param[in]       size: Output buffer size, see \ref HSM_SNAPSHOT_SIZE
+ * \return          Snapshot size in bytes, `0` on error or if `buf` is too small
+ */
+size_t
+hsm_snapshot(const hsm_t* hsm, hsm_state_t* const* states, uint8_t count, void* buf, size_t size) {
+    uint8_t* b = buf;
+    size_t len = PRV_SNAP_HDR_SIZE;
+    uint16_t events = 0, urgent = 0;
+
+    if (hsm == NULL || states == NULL || b == NULL || count == 0 || count == PRV_SNAP_ID_NONE
+        || size < HSM_SNAPSHOT_SIZE(count, 0, 0)) {
+        return 0;
+    }
+
+    memcpy(b, "HSMS", 4);
+    b[4] = PRV_SNAP_VERSION;
+    b[5] = count;
+    b[6] = (uint8_t)sizeof(void*);
+    if (!prv_snap_save(hsm, states, count, b, size, &len)) {
+        return 0;
+    }
+#if HSM_CFG_QUEUE
+#if HSM_CFG_QUEUE_URGENT
+    if (!prv_snap_queue(&hsm->urgent, b, size, &len, &urgent)) {
+        return 0;
+    }
+#endif /* HSM_CFG_QUEUE_URGENT */
+    if (!prv_snap_queue(&hsm->queue, b, size, &len, &events)) {
+        return 0;
+    }
+#endif /* HSM_CFG_QUEUE */
+
+    b[7] = (uint8_t)events;
+    b[8] = (uint8_t)(events >> 8);
+    b[9] = (uint8_t)urgent;
+    b[10] = (uint8_t)(urgent >> 8);
+    prv_snap_put_u32(&b[len], prv_snap_hash(b, len));
+
+    return len + 4;
+}
+
+/**
+ * \brief           Check, then apply, record of an instance and of its regions
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       states: State set
+ * \param[in]       count: Number of states in set
+ * \param[in]       b: Snapshot
+ * \param[in]       end: End of records and events, before the hash
+ * \param[in,out]   pos: Position of the record, advanced past it
+ * \param[in]       apply: `0` to only check the records, `1` to restore them
+ * \return          \ref HSM_RES_OK on success, member of \ref hsm_result_t otherwise
+ */
+static hsm_result_t
+prv_snap_load(hsm_t* hsm, hsm_state_t* const* states, uint8_t count, const uint8_t* b, size_t end,
+              size_t* pos, uint8_t apply) {
+    const uint8_t* r = &b[*pos];
+    hsm_result_t res = HSM_RES_OK;
+    uint16_t regions = 0;
+
+    if (*pos + PRV_SNAP_INST_SIZE(count) > end
+        || *pos + PRV_SNAP_INST_SIZE(count) + (size_t)r[5] * PRV_SNAP_EVT_SIZE > end || r[0] >= count
+        || r[1] >= count || (r[2] >= count && r[2] != PRV_SNAP_ID_NONE) || r[3] > 1) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#if HSM_CFG_STATE_HISTORY
+    for (uint8_t s = 0; s < count; s++) {
+        if (r[6 + s] >= count && r[6 + s] != PRV_SNAP_ID_NONE) {
+            return HSM_RES_INVALID_PARAM;
+        }
+    }
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_EVENT_DEFER
+    if (r[5] > HSM_CFG_EVENT_DEFER_SIZE) {
+        return HSM_RES_FULL;
+    }
+#else
+    if (r[5] > 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#endif /* HSM_CFG_EVENT_DEFER */
+
+    if (apply) {
+        prv_reset_config(hsm, states[r[1]]);
+        hsm->current = states[r[0]];
+        hsm->depth = hsm->current->depth;
+#if HSM_CFG_HISTORY
+        hsm->history = (r[2] != PRV_SNAP_ID_NONE) ? states[r[2]] : NULL;
 #endif /* HSM_CFG_HISTORY */
+#if HSM_CFG_REGIONS
+        hsm->region_active = r[3];
+#endif /* HSM_CFG_REGIONS */
+#if HSM_CFG_STATE_HISTORY
+        for (uint8_t s = 0; s < count; s++) {
+            if (r[6 + s] != PRV_SNAP_ID_NONE && states[s]->keeps_history) {
+                prv_history_set(hsm, states[s], states[r[6 + s]]);
+            }
+        }
+#endif /* HSM_CFG_STATE_HISTORY */
+#if HSM_CFG_EVENT_DEFER
+        for (uint8_t i = 0; i < r[5]; i++) {
+            const uint8_t* e = &r[PRV_SNAP_INST_SIZE(count) + i * PRV_SNAP_EVT_SIZE];
+
+            hsm->defer_store[i].event = prv_snap_get_u32(e);
+            memcpy(&hsm->defer_store[i].data, &e[4], sizeof(void*));
+        }
+        hsm->defer_count = r[5];
+#endif /* HSM_CFG_EVENT_DEFER */
+    }
+    *pos += PRV_SNAP_INST_SIZE(count) + (size_t)r[5] * PRV_SNAP_EVT_SIZE;
+
+#if HSM_CFG_REGIONS
+    for (hsm_t* region = hsm->regions; region != NULL && res == HSM_RES_OK; region = region->next_region) {
+        regions++;
+        res = prv_snap_load(region, states, count, b, end, pos, apply);
+    }
+#endif /* HSM_CFG_REGIONS */
+    if (res == HSM_RES_OK && regions != r[4]) {
+        res = HSM_RES_INVALID_PARAM;
+    }
+    return res;
+}
+
+#if HSM_CFG_QUEUE
+/**
+ * \brief           Empty a queue and fill it with saved events
+ *
+ * Slots are written in place: restoring is not a post, so no notification
+ * is called and the queue statistics are left alone.
+ *
+ * \param[in]       q: Pointer to queue, with storage
+ * \param[in]       b: Snapshot
+ * \param[in]       pos: Position of the first event
+ * \param[in]       events: Number of events, fits the queue
+ * \return          Position after the last event
+ */
+static size_t
+prv_snap_refill(hsm_queue_t* q, const uint8_t* b, size_t pos, uint16_t events) {
+    uint32_t i;
+
+    prv_queue_setup(q, q->slots, q->mask + 1);
+    for (i = 0; i < events; i++, pos += PRV_SNAP_EVT_SIZE) {
+        q->slots[i].event = prv_snap_get_u32(&b[pos]);
+        memcpy(&q->slots[i].data, &b[pos + 4], sizeof(void*));
+        q->slots[i].seq = i + 1;
+    }
+    q->head = events;
+    return pos;
+}
+#endif /* HSM_CFG_QUEUE */
+
+/**
+ * \brief           Restore HSM instance from snapshot
+ *
+ * Brings the instance and its regions into the saved configuration,
+ * without running any ENTRY handler, and refills deferred events, the
+ * urgent lane and the queue. Refilled events are not posts: queue
+ * notifications are not called and queue statistics do not change.
+ *
+ * The instance must be zero-initialized or initialized with \ref hsm_init.
+ * Everything attached to it before the call is kept: queue and urgent lane
+ * storage with their notification, regions added with \ref hsm_region_add
+ * (same composites and order as when the snapshot was taken), compiled
+ * table, unhandled callback, state slots, counters, trace id and timers.
+ * The snapshot is fully checked before the instance is changed.
+ *
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       name: HSM name
+ * \param[in]       states: State set used by \ref hsm_snapshot
+ * \param[in]       count: Number of states in set
+ * \param[in]       buf: Snapshot
+ * \param[in]       len: Snapshot size in bytes
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_INVALID_PARAM if
+ *                  snapshot is corrupted or does not match the state set, the
+ *                  regions or the queues, \ref HSM_RES_FULL if saved events
+ *                  do not fit the queues or the deferred event store
+ */
+hsm_result_t
+hsm_restore(hsm_t* hsm, const char* name, hsm_state_t* const* states, uint8_t count, const void* buf,
+            size_t len) {
+    const uint8_t* b = buf;
+    size_t pos = PRV_SNAP_HDR_SIZE;
+    hsm_result_t res;
+    uint16_t events, urgent;
+
+    if (hsm == NULL || states == NULL || b == NULL || count == 0 || len < HSM_SNAPSHOT_SIZE(count, 0, 0)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    events = (uint16_t)(b[7] | (b[8] << 8));
+    urgent = (uint16_t)(b[9] | (b[10] << 8));
+    if (memcmp(b, "HSMS", 4) != 0 || b[4] != PRV_SNAP_VERSION || b[5] != count || b[6] != sizeof(void*)
+        || prv_snap_get_u32(&b[len - 4]) != prv_snap_hash(b, len - 4)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    /* Check everything before the instance is changed */
+    res = prv_snap_load(hsm, states, count, b, len - 4, &pos, 0);
+    if (res != HSM_RES_OK) {
+        return res;
+    }
+    if (pos + ((size_t)events + urgent) * PRV_SNAP_EVT_SIZE != len - 4) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#if HSM_CFG_QUEUE
+    if (events > 0 && hsm->queue.slots == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    if (events > hsm->queue.mask + 1) {
+        return HSM_RES_FULL;
+    }
+#else
+    if (events > 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#endif /* HSM_CFG_QUEUE */
+#if HSM_CFG_QUEUE && HSM_CFG_QUEUE_URGENT
+    if (urgent > 0 && hsm->urgent.slots == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    if (urgent > hsm->urgent.mask + 1) {
+        return HSM_RES_FULL;
+    }
+#else
+    if (urgent > 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+#endif /* HSM_CFG_QUEUE && HSM_CFG_QUEUE_URGENT */
+
+    pos = PRV_SNAP_HDR_SIZE;
+    prv_snap_load(hsm, states, count, b, len - 4, &pos, 1);
+    prv_set_name(hsm, name);
+
+#if HSM_CFG_QUEUE
+#if HSM_CFG_QUEUE_URGENT
+    if (hsm->urgent.slots != NULL) {
+        pos = prv_snap_refill(&hsm->urgent, b, pos, urgent);
+    }
+#endif /* HSM_CFG_QUEUE_URGENT */
+    if (hsm->queue.slots != NULL) {
+        prv_snap_refill(&hsm->queue, b, pos, events);
+    }
+#endif /* HSM_CFG_QUEUE */
+
+    return HSM_RES_OK;
+}
+#endif /* HSM_CFG_SNAPSHOT */
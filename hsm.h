@@ -34,6 +34,7 @@
 #ifndef HSM_HDR_H
 #define HSM_HDR_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -62,8 +63,23 @@ typedef enum {
     HSM_RES_ERROR,                            /*!< Generic error */
     HSM_RES_INVALID_PARAM,                    /*!< Invalid parameter */
     HSM_RES_MAX_DEPTH,                        /*!< Maximum depth exceeded */
+    HSM_RES_FULL,                             /*!< Event queue is full */
+    HSM_RES_UNHANDLED,                        /*!< Event reached no handler that consumed it */
 } hsm_result_t;
 
+#if HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER
+/**
+ * \brief           Set of user events, bit `n` is event `HSM_EVENT_USER + n`
+ */
+#if HSM_CFG_EVENT_MASK_BITS == 64
+typedef uint64_t hsm_event_mask_t;
+#elif HSM_CFG_EVENT_MASK_BITS == 32
+typedef uint32_t hsm_event_mask_t;
+#else
+#error "HSM_CFG_EVENT_MASK_BITS must be 32 or 64"
+#endif
+#endif /* HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER */
+
 /**
  * \}
  */
@@ -77,17 +93,81 @@ typedef enum {
 #define HSM_EVENT_NONE 0x00                   /*!< No event */
 #define HSM_EVENT_ENTRY 0x01                  /*!< State entry event */
 #define HSM_EVENT_EXIT 0x02                   /*!< State exit event */
+#if HSM_CFG_ASYNC
+#define HSM_EVENT_PENDING 0x03                /*!< ENTRY handler result, entry completes later */
+#endif /* HSM_CFG_ASYNC */
 #define HSM_EVENT_USER 0x10                   /*!< User events start from here */
 
+#if HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER
+/**
+ * \brief           Event mask bit of user event
+ * \param[in]       evt: User event, `HSM_EVENT_USER` up to
+ *                      `HSM_EVENT_USER + HSM_CFG_EVENT_MASK_BITS - 1`
+ */
+#define HSM_EVENT_BIT(evt) ((hsm_event_mask_t)1 << ((evt) - HSM_EVENT_USER))
+
+#define HSM_EVENT_MASK_ALL ((hsm_event_mask_t)~(hsm_event_mask_t)0) /*!< State handles every event */
+#endif /* HSM_CFG_EVENT_MASK || HSM_CFG_EVENT_DEFER */
+
 /**
  * \}
  */
 
+#if HSM_CFG_TRACE
+/**
+ * \brief           Trace point type
+ */
+typedef enum {
+    HSM_TRACE_DISPATCH_BEGIN = 0x00,          /*!< Dispatch started, state is current state */
+    HSM_TRACE_DISPATCH_END,                   /*!< Dispatch finished, state is current state */
+    HSM_TRACE_HANDLER,                        /*!< Handler invoked for propagated event */
+    HSM_TRACE_EXIT,                           /*!< State EXIT step */
+    HSM_TRACE_ENTRY,                          /*!< State ENTRY step */
+    HSM_TRACE_TRANSITION_BEGIN,               /*!< Transition started, state is target */
+    HSM_TRACE_TRANSITION_END,                 /*!< Transition finished, state is new current */
+    HSM_TRACE_DEFERRED,                       /*!< Transition deferred, state is target */
+    HSM_TRACE_TRANSITION_ABORT,               /*!< Transition path too deep, not run, state is target */
+} hsm_trace_type_t;
+
+#if HSM_CFG_TRACE_HISTOGRAM
+/**
+ * \brief           Log2 latency histogram
+ */
+typedef struct {
+    uint32_t bins[HSM_CFG_TRACE_HISTOGRAM_BINS]; /*!< Sample count per power of two cycles */
+} hsm_trace_hist_t;
+#endif /* HSM_CFG_TRACE_HISTOGRAM */
+
+#if HSM_CFG_TRACE_RING
+#define HSM_TRACE_ID_NONE 0xFFFF              /*!< Trace record without state */
+
+/**
+ * \brief           Binary trace record
+ */
+typedef struct {
+    uint32_t timestamp;                       /*!< `HSM_PORT_CYCLES()` at trace point */
+    uint32_t event;                           /*!< Event, `HSM_EVENT_NONE` for transitions */
+    uint16_t state;                           /*!< State id or \ref HSM_TRACE_ID_NONE */
+    uint8_t hsm;                              /*!< HSM instance id */
+    uint8_t type;                             /*!< Trace point type, \ref hsm_trace_type_t */
+} hsm_trace_record_t;
+
+/**
+ * \brief           Trace dump output function
+ * \param[in]       data: Bytes to write
+ * \param[in]       len: Number of bytes
+ * \param[in]       arg: User argument
+ */
+typedef void (*hsm_trace_write_fn)(const void* data, size_t len, void* arg);
+#endif /* HSM_CFG_TRACE_RING */
+#endif /* HSM_CFG_TRACE */
+
 /**
  * \brief           Forward declarations
  */
 struct hsm;
 struct hsm_state;
+struct hsm_timer;
 
 /**
  * \brief           State handler function prototype
@@ -98,29 +178,321 @@ struct hsm_state;
  */
 typedef hsm_event_t (*hsm_state_fn_t)(struct hsm* hsm, hsm_event_t event, void* data);
 
+/**
+ * \brief           Event with its data, used by \ref hsm_dispatch_batch
+ */
+typedef struct {
+    hsm_event_t event;                        /*!< Event to dispatch */
+    void* data;                               /*!< Event data */
+} hsm_batch_event_t;
+
+#if HSM_CFG_UNHANDLED
+/**
+ * \brief           Unhandled event callback prototype, see \ref hsm_set_unhandled
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event no state consumed
+ * \param[in]       data: Event data pointer
+ */
+typedef void (*hsm_unhandled_fn_t)(struct hsm* hsm, hsm_event_t event, void* data);
+#endif /* HSM_CFG_UNHANDLED */
+
+#if HSM_CFG_EVENT_TABLE
+/**
+ * \brief           Event table entry, see \ref hsm_state_set_table
+ *
+ * Entry with both fields `NULL` leaves the event to the state handler.
+ */
+typedef struct {
+    hsm_state_fn_t action;                    /*!< Action, returns event to propagate or `HSM_EVENT_NONE` */
+    const struct hsm_state* target;           /*!< Transition target when consumed, `NULL` for none */
+} hsm_event_entry_t;
+#endif /* HSM_CFG_EVENT_TABLE */
+
+#if HSM_CFG_GUARDS
+/**
+ * \brief           Transition guard prototype
+ * \param[in]       hsm: Pointer to HSM instance
+ * \param[in]       event: Event being dispatched
+ * \param[in]       data: Event data pointer
+ * \return          `1` to take the transition, `0` otherwise
+ */
+typedef uint8_t (*hsm_guard_fn_t)(struct hsm* hsm, hsm_event_t event, void* data);
+
+/**
+ * \brief           Declarative transition, see \ref hsm_state_set_transitions
+ */
+typedef struct {
+    hsm_event_t event;                        /*!< Triggering user event */
+    hsm_guard_fn_t guard;                     /*!< Guard, `NULL` when always taken */
+    const struct hsm_state* target;           /*!< Target state, `NULL` for internal transition */
+    void (*action)(struct hsm* hsm, void* param); /*!< Action between EXIT and ENTRY, or `NULL` */
+} hsm_transition_t;
+#endif /* HSM_CFG_GUARDS */
+
+#if HSM_CFG_STATS
+/**
+ * \brief           State counters, see \ref hsm_state_stats_get
+ */
+typedef struct {
+    uint32_t entries;                         /*!< ENTRY events delivered */
+    uint32_t exits;                           /*!< EXIT events delivered */
+    uint32_t handled;                         /*!< Dispatched events consumed by the state */
+    uint32_t propagated;                      /*!< Dispatched events passed on to the parent */
+} hsm_state_stats_t;
+
+/**
+ * \brief           Instance counters, see \ref hsm_stats_get
+ */
+typedef struct {
+    uint32_t dispatches;                      /*!< Dispatched events */
+    uint32_t transitions;                     /*!< Executed transitions */
+    uint32_t unhandled;                       /*!< Events no state consumed */
+    uint32_t deferred;                        /*!< Transitions queued while another one was running */
+    uint32_t queue_max;                       /*!< Highest observed queue depth */
+} hsm_stats_t;
+#endif /* HSM_CFG_STATS */
+
+#if HSM_CFG_STATE_HISTORY
+/**
+ * \brief           History pseudo-state kind
+ */
+typedef enum {
+    HSM_HISTORY_NONE = 0x00,                  /*!< Regular state */
+    HSM_HISTORY_SHALLOW,                      /*!< Resume last active direct child of parent */
+    HSM_HISTORY_DEEP,                         /*!< Resume last active leaf below parent */
+} hsm_history_t;
+
+/**
+ * \brief           History of one composite state, kept by the HSM instance
+ */
+typedef struct {
+    const struct hsm_state* composite;        /*!< Composite state with history, `NULL` when free */
+    const struct hsm_state* last_active;      /*!< Active leaf when `composite` was last exited */
+} hsm_history_slot_t;
+#endif /* HSM_CFG_STATE_HISTORY */
+
 /**
  * \brief           HSM state structure
  */
 typedef struct hsm_state {
     hsm_state_fn_t handler;                   /*!< State handler function */
-    struct hsm_state* parent;                 /*!< Parent state pointer */
+    const struct hsm_state* parent;           /*!< Parent state pointer */
     const char* name;                         /*!< State name for debugging */
+    uint8_t depth;                            /*!< Depth in hierarchy, 0 for root */
+
+#if HSM_CFG_INITIAL
+    const struct hsm_state* initial;          /*!< Default child entered with this state, or `NULL` */
+#endif /* HSM_CFG_INITIAL */
+
+#if HSM_CFG_STATE_HISTORY
+    uint8_t history;                          /*!< Pseudo-state kind, \ref hsm_history_t */
+    uint8_t keeps_history;                    /*!< Target of a pseudo-state, exits are recorded */
+#endif /* HSM_CFG_STATE_HISTORY */
+
+#if HSM_CFG_EVENT_MASK
+    hsm_event_mask_t events;                  /*!< User events handled by this state */
+#endif /* HSM_CFG_EVENT_MASK */
+
+#if HSM_CFG_EVENT_DEFER
+    hsm_event_mask_t defer;                   /*!< User events postponed while this state is active */
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_GUARDS
+    const hsm_transition_t* transitions;      /*!< Declarative transitions, checked in order */
+    uint8_t transition_count;                 /*!< Number of declarative transitions */
+#endif /* HSM_CFG_GUARDS */
+
+#if HSM_CFG_EVENT_TABLE
+    const hsm_event_entry_t* table;           /*!< Event table, indexed by `event - table_first` */
+    hsm_event_t table_first;                  /*!< Event of first table entry */
+    uint16_t table_count;                     /*!< Number of table entries */
+#endif /* HSM_CFG_EVENT_TABLE */
+
+#if HSM_CFG_COMPILED
+    uint8_t index;                            /*!< Position in compiled state set */
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM)
+    uint16_t slot;                            /*!< Position in state slot sets plus one, `0` if none */
+#endif /* HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM) */
+
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_RING
+    uint16_t id;                              /*!< Trace id, assigned at creation */
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_RING */
 } hsm_state_t;
 
+#if HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM)
+/**
+ * \brief           Per-instance record of one state, see \ref hsm_set_state_slots
+ */
+typedef struct {
+    const hsm_state_t* state;                 /*!< State the record belongs to */
+#if HSM_CFG_STATS
+    hsm_state_stats_t stats;                  /*!< Counters of the state in this instance */
+#endif /* HSM_CFG_STATS */
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM
+    hsm_trace_hist_t latency;                 /*!< Handler invocation latency in this instance */
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM */
+} hsm_state_slot_t;
+#endif /* HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM) */
+
+#if HSM_CFG_SNAPSHOT
+/**
+ * \brief           Snapshot buffer size for a set of `states`, `regions` added to the
+ *                  instance and up to `events` queued, urgent and deferred events
+ */
+#define HSM_SNAPSHOT_SIZE(states, regions, events)                                                 \
+    (11 + ((regions) + 1) * (6 + (HSM_CFG_STATE_HISTORY ? (states) : 0)) + (events) * (4 + sizeof(void*)) + 4)
+#endif /* HSM_CFG_SNAPSHOT */
+
+#if HSM_CFG_COMPILED
+/**
+ * \brief           Number of `uint8_t` table entries needed to compile `n` states
+ */
+#define HSM_COMPILED_TABLE_SIZE(n) ((n) * (n))
+
+/**
+ * \brief           Number of path entries needed to compile `n` states
+ */
+#define HSM_COMPILED_PATHS_SIZE(n) ((n) * HSM_CFG_MAX_DEPTH)
+
+/**
+ * \brief           Compiled transition table for a fixed set of states
+ *
+ * For every state of the set, `paths` holds its ancestors ordered from
+ * root to the state itself. For every (source, target) pair, `table`
+ * holds the number of leading path entries both states share.
+ * Entries on the diagonal hold the path length of each state.
+ */
+typedef struct hsm_compiled {
+    hsm_state_t* const* states;               /*!< State set, position is state index */
+    const hsm_state_t** paths;                /*!< Ancestor paths, `HSM_CFG_MAX_DEPTH` per state */
+    uint8_t* table;                           /*!< Shared ancestor count per state pair */
+    uint8_t count;                            /*!< Number of states in the set */
+} hsm_compiled_t;
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_QUEUE
+/**
+ * \brief           Event queue slot
+ */
+typedef struct {
+    uint32_t seq;                             /*!< Slot sequence number */
+    hsm_event_t event;                        /*!< Queued event */
+    void* data;                               /*!< Queued event data */
+} hsm_queue_slot_t;
+
+/**
+ * \brief           Lock-free multi-producer single-consumer event queue
+ */
+typedef struct {
+    hsm_queue_slot_t* slots;                  /*!< Slot storage, `NULL` when not configured */
+    uint32_t mask;                            /*!< Number of slots minus one */
+    uint32_t head;                            /*!< Next position to write, shared by producers */
+    uint32_t tail;                            /*!< Next position to read, owned by consumer */
+    uint8_t processing;                       /*!< Queue is being drained */
+    void (*notify)(struct hsm* hsm, void* arg); /*!< Called after each successful post */
+    void* notify_arg;                         /*!< User argument of `notify` */
+} hsm_queue_t;
+#endif /* HSM_CFG_QUEUE */
+
+/**
+ * \brief           Transition requested while another transition is running
+ */
+typedef struct {
+    const hsm_state_t* target;                /*!< Target state */
+    void* param;                              /*!< Parameter passed to ENTRY and EXIT events */
+    void (*method)(struct hsm* hsm, void* param); /*!< Optional hook called between EXIT and ENTRY */
+} hsm_deferred_t;
+
 /**
  * \brief           HSM instance structure
  */
 typedef struct hsm {
-    hsm_state_t* current;                     /*!< Current state */
-    hsm_state_t* initial;                     /*!< Initial state */
-    hsm_state_t* next;                        /*!< Deferred transition target */
+    const hsm_state_t* current;               /*!< Current state */
+    const hsm_state_t* initial;               /*!< Initial state */
     const char* name;                         /*!< HSM name for debugging */
     uint8_t depth;                            /*!< Current state depth */
     uint8_t in_transition;                    /*!< Transition in progress flag */
+    uint8_t deferred_head;                    /*!< First pending deferred transition */
+    uint8_t deferred_count;                   /*!< Number of pending deferred transitions */
+    hsm_deferred_t deferred[HSM_CFG_DEFER_SIZE]; /*!< Deferred transition queue */
     
 #if HSM_CFG_HISTORY
-    hsm_state_t* history;                     /*!< Previous state for history */
+    const hsm_state_t* history;               /*!< Previous state for history */
 #endif /* HSM_CFG_HISTORY */
+
+#if HSM_CFG_STATE_HISTORY
+    hsm_history_slot_t history_slots[HSM_CFG_HISTORY_SLOTS]; /*!< Per-instance state history */
+#endif /* HSM_CFG_STATE_HISTORY */
+
+#if HSM_CFG_COMPILED
+    const hsm_compiled_t* compiled;           /*!< Compiled transition table or `NULL` */
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_QUEUE
+    hsm_queue_t queue;                        /*!< Posted event queue */
+#if HSM_CFG_QUEUE_URGENT
+    hsm_queue_t urgent;                       /*!< Urgent lane, drained before `queue` */
+#endif /* HSM_CFG_QUEUE_URGENT */
+#endif /* HSM_CFG_QUEUE */
+
+#if HSM_CFG_TIMER
+    struct hsm_timer* timers;                 /*!< Armed timers posting to this instance */
+#endif /* HSM_CFG_TIMER */
+
+#if HSM_CFG_ASYNC
+    const hsm_state_t* async_state;           /*!< State waiting to complete its ENTRY */
+    const hsm_state_t* async_target;          /*!< Final state of the suspended transition */
+    void* async_param;                        /*!< Parameter of the suspended transition */
+#endif /* HSM_CFG_ASYNC */
+
+#if HSM_CFG_EVENT_DEFER
+    uint8_t defer_flags;                      /*!< Recall pending and dispatch running flags */
+    uint8_t defer_head;                       /*!< Oldest deferred event */
+    uint8_t defer_count;                      /*!< Number of deferred events */
+    hsm_batch_event_t defer_store[HSM_CFG_EVENT_DEFER_SIZE]; /*!< Deferred events, oldest first */
+#endif /* HSM_CFG_EVENT_DEFER */
+
+#if HSM_CFG_SCHED
+    uint32_t sched_state;                     /*!< Scheduling state, owned by scheduler */
+    uint8_t sched_home;                       /*!< Home worker index */
+#endif /* HSM_CFG_SCHED */
+
+#if HSM_CFG_REGIONS
+    struct hsm* region_parent;                /*!< Owning instance, `NULL` when not a region */
+    const hsm_state_t* region_owner;          /*!< Composite state the region belongs to */
+    struct hsm* regions;                      /*!< First region of this instance */
+    struct hsm* next_region;                  /*!< Next region of the same owning instance */
+    uint8_t region_active;                    /*!< Region entered flag */
+#endif /* HSM_CFG_REGIONS */
+
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM
+    hsm_trace_hist_t dispatch_latency;        /*!< Dispatch latency */
+    hsm_trace_hist_t transition_latency;      /*!< Transition latency */
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM */
+
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_RING
+    uint8_t id;                               /*!< Trace id, assigned at initialization */
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_RING */
+
+#if HSM_CFG_STATS
+    hsm_stats_t stats;                        /*!< Instance counters */
+#endif /* HSM_CFG_STATS */
+
+#if HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM)
+    hsm_state_slot_t* state_slots;            /*!< Per-state counters of this instance, or `NULL` */
+    uint16_t state_slot_count;                /*!< Number of entries in `state_slots` */
+#endif /* HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM) */
+
+#if HSM_CFG_UNHANDLED
+    hsm_unhandled_fn_t unhandled;             /*!< Called for events no state consumed, or `NULL` */
+#if HSM_CFG_EVENT_MASK
+    const hsm_state_t* reach_leaf;            /*!< Current state `reach` was computed for */
+    hsm_event_mask_t reach;                   /*!< User events handled or deferred by the chain */
+    uint32_t reach_gen;                       /*!< Definition generation `reach` was computed in */
+#endif /* HSM_CFG_EVENT_MASK */
+#endif /* HSM_CFG_UNHANDLED */
 } hsm_t;
 
 /**
@@ -130,23 +502,131 @@ typedef struct hsm {
  */
 
 /* Initialization functions */
-hsm_result_t hsm_init(hsm_t* hsm, const char* name, hsm_state_t* initial_state);
+hsm_result_t hsm_init(hsm_t* hsm, const char* name, const hsm_state_t* initial_state);
+hsm_result_t hsm_validate(hsm_state_t* const* states, uint16_t count, uint16_t* failed);
 hsm_result_t hsm_state_create(hsm_state_t* state, const char* name, hsm_state_fn_t handler,
-                               hsm_state_t* parent);
+                               const hsm_state_t* parent);
+#if HSM_CFG_EVENT_MASK
+hsm_result_t hsm_state_create_ex(hsm_state_t* state, const char* name, hsm_state_fn_t handler,
+                                  const hsm_state_t* parent, hsm_event_mask_t events);
+#endif /* HSM_CFG_EVENT_MASK */
+#if HSM_CFG_INITIAL
+hsm_result_t hsm_state_set_initial(hsm_state_t* state, const hsm_state_t* child);
+#endif /* HSM_CFG_INITIAL */
+#if HSM_CFG_EVENT_DEFER
+hsm_result_t hsm_state_set_defer(hsm_state_t* state, hsm_event_mask_t events);
+#endif /* HSM_CFG_EVENT_DEFER */
+#if HSM_CFG_GUARDS
+hsm_result_t hsm_state_set_transitions(hsm_state_t* state, const hsm_transition_t* transitions,
+                                       uint8_t count);
+#endif /* HSM_CFG_GUARDS */
+#if HSM_CFG_EVENT_TABLE
+hsm_result_t hsm_state_set_table(hsm_state_t* state, hsm_event_t first, const hsm_event_entry_t* table,
+                                 uint16_t count);
+#endif /* HSM_CFG_EVENT_TABLE */
+#if HSM_CFG_STATE_HISTORY
+hsm_result_t hsm_state_create_history(hsm_state_t* state, const char* name, hsm_state_t* composite,
+                                      hsm_history_t kind);
+#endif /* HSM_CFG_STATE_HISTORY */
 
 /* Event handling */
 hsm_result_t hsm_dispatch(hsm_t* hsm, hsm_event_t event, void* data);
-hsm_result_t hsm_transition(hsm_t* hsm, hsm_state_t* target, void* param,
+uint32_t hsm_dispatch_batch(hsm_t* hsm, const hsm_batch_event_t* events, uint32_t count,
+                            const hsm_state_t* stop);
+uint32_t hsm_dispatch_fanout(hsm_t* const* hsms, uint32_t count, hsm_event_t event, void* data);
+hsm_result_t hsm_transition(hsm_t* hsm, const hsm_state_t* target, void* param,
                              void (*method)(hsm_t* hsm, void* param));
 
 /* Query functions */
-hsm_state_t* hsm_get_current_state(hsm_t* hsm);
-uint8_t hsm_is_in_state(hsm_t* hsm, hsm_state_t* state);
+const hsm_state_t* hsm_get_current_state(const hsm_t* hsm);
+uint8_t hsm_is_in_state(const hsm_t* hsm, const hsm_state_t* state);
+#if HSM_CFG_ASYNC
+uint8_t hsm_is_pending(const hsm_t* hsm);
+#endif /* HSM_CFG_ASYNC */
+
+#if HSM_CFG_UNHANDLED
+hsm_result_t hsm_set_unhandled(hsm_t* hsm, hsm_unhandled_fn_t fn);
+#endif /* HSM_CFG_UNHANDLED */
+
+#if HSM_CFG_STATS
+/* Statistics */
+hsm_result_t hsm_stats_get(const hsm_t* hsm, hsm_stats_t* stats);
+hsm_result_t hsm_stats_reset(hsm_t* hsm);
+hsm_result_t hsm_state_stats_get(const hsm_t* hsm, const hsm_state_t* state, hsm_state_stats_t* stats);
+hsm_result_t hsm_state_stats_reset(hsm_t* hsm, const hsm_state_t* state);
+#endif /* HSM_CFG_STATS */
+
+#if HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM)
+hsm_result_t hsm_set_state_slots(hsm_t* hsm, hsm_state_slot_t* slots, hsm_state_t* const* states,
+                                 uint16_t count);
+#endif /* HSM_CFG_STATS || (HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM) */
 
 #if HSM_CFG_HISTORY
 hsm_result_t hsm_transition_history(hsm_t* hsm);
 #endif /* HSM_CFG_HISTORY */
 
+#if HSM_CFG_REGIONS
+/* Orthogonal regions */
+hsm_result_t hsm_region_add(hsm_t* hsm, const hsm_state_t* composite, hsm_t* region, const char* name,
+                            const hsm_state_t* initial_state);
+hsm_t* hsm_region_get_parent(hsm_t* region);
+#endif /* HSM_CFG_REGIONS */
+
+#if HSM_CFG_COMPILED
+/* Compiled transitions */
+hsm_result_t hsm_compile(hsm_compiled_t* compiled, hsm_state_t* const* states, uint8_t count,
+                         const hsm_state_t** paths, uint8_t* table);
+hsm_result_t hsm_set_compiled(hsm_t* hsm, const hsm_compiled_t* compiled);
+#endif /* HSM_CFG_COMPILED */
+
+#if HSM_CFG_QUEUE
+/* Event queue */
+hsm_result_t hsm_queue_init(hsm_t* hsm, hsm_queue_slot_t* slots, uint32_t size);
+hsm_result_t hsm_post(hsm_t* hsm, hsm_event_t event, void* data);
+hsm_result_t hsm_process(hsm_t* hsm);
+hsm_result_t hsm_process_max(hsm_t* hsm, uint32_t max);
+uint8_t hsm_queue_pending(const hsm_t* hsm);
+hsm_result_t hsm_queue_set_notify(hsm_t* hsm, void (*notify)(hsm_t* hsm, void* arg), void* arg);
+#if HSM_CFG_QUEUE_URGENT
+hsm_result_t hsm_queue_init_urgent(hsm_t* hsm, hsm_queue_slot_t* slots, uint32_t size);
+hsm_result_t hsm_post_urgent(hsm_t* hsm, hsm_event_t event, void* data);
+hsm_result_t hsm_queue_set_notify_urgent(hsm_t* hsm, void (*notify)(hsm_t* hsm, void* arg), void* arg);
+#endif /* HSM_CFG_QUEUE_URGENT */
+#endif /* HSM_CFG_QUEUE */
+
+#if HSM_CFG_EVENT_POOL
+/* Event payload pool */
+void* hsm_event_alloc(size_t size);
+void hsm_event_ref(void* data);
+void hsm_event_release(void* data);
+uint8_t hsm_event_is_pooled(const void* data);
+#endif /* HSM_CFG_EVENT_POOL */
+
+#if HSM_CFG_SNAPSHOT
+/* Warm restart */
+size_t hsm_snapshot(const hsm_t* hsm, hsm_state_t* const* states, uint8_t count, void* buf, size_t size);
+hsm_result_t hsm_restore(hsm_t* hsm, const char* name, hsm_state_t* const* states, uint8_t count,
+                         const void* buf, size_t len);
+#endif /* HSM_CFG_SNAPSHOT */
+
+#if HSM_CFG_TRACE && defined(HSM_CFG_TRACE_HOOK)
+/* Application trace hook */
+void HSM_CFG_TRACE_HOOK(hsm_t* hsm, hsm_trace_type_t type, const hsm_state_t* state, hsm_event_t event);
+#endif /* HSM_CFG_TRACE && defined(HSM_CFG_TRACE_HOOK) */
+
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM
+/* Latency histograms */
+void hsm_trace_hist_clear(hsm_trace_hist_t* hist);
+uint32_t hsm_trace_hist_percentile(const hsm_trace_hist_t* hist, uint8_t percent);
+hsm_trace_hist_t* hsm_state_latency(hsm_t* hsm, const hsm_state_t* state);
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_HISTOGRAM */
+
+#if HSM_CFG_TRACE && HSM_CFG_TRACE_RING
+/* Binary trace ring */
+void hsm_trace_ring_clear(void);
+void hsm_trace_ring_dump(hsm_trace_write_fn write, void* arg);
+#endif /* HSM_CFG_TRACE && HSM_CFG_TRACE_RING */
+
 /**
  * \}
  */
@@ -0,0 +1,412 @@
+/**
+ * \file            hsm.hpp
+ * \brief           C++17 header-only front end
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ * Version:         2.0.0
+ */
+#ifndef HSM_HPP_HDR_H
+#define HSM_HPP_HDR_H
+
+#include <stdint.h>
+#include <type_traits>
+#include "hsm.h"
+
+#if __cplusplus < 201703L
+#error "hsm.hpp requires C++17"
+#endif
+
+/**
+ * \defgroup        HSM_CPP C++ front end
+ * \brief           Header-only, compile-time specialised state machines
+ *
+ * States are types, the hierarchy is given by each state's `parent` type.
+ * Every `(current, target)` transition and every dispatch chain is
+ * resolved at compile time, so handlers are called directly and can be
+ * inlined; the only runtime lookup is one table jump on the current state
+ * index.
+ *
+ * Semantics follow the C API: events propagate to the parent until a
+ * handler returns `HSM_EVENT_NONE`, transitions exit up to the lowest common
+ * ancestor, call the method hook and enter down to the target, and
+ * transitions requested during a transition are queued in a FIFO of
+ * `HSM_CFG_DEFER_SIZE` entries.
+ *
+ * \code{.cpp}
+ * struct Blinker;
+ * struct Root : hsmpp::state<> {
+ *     static hsm_event_t handle(Blinker& m, hsm_event_t event, void* data);
+ * };
+ * struct On : hsmpp::state<Root> {
+ *     static hsm_event_t handle(Blinker& m, hsm_event_t event, void* data);
+ * };
+ * struct Blinker : hsmpp::machine<Blinker, Root, On> {
+ *     int count = 0;
+ * };
+ * \endcode
+ *
+ * \{
+ */
+
+namespace hsmpp {
+
+/**
+ * \brief           Parent type of top level states
+ */
+struct root {};
+
+/**
+ * \brief           Base of user state types
+ * \tparam          Parent: Parent state type, \ref root for top level states
+ *
+ * Derived states provide
+ * `static hsm_event_t handle(Machine& m, hsm_event_t event, void* data)`
+ * and optionally `using initial = Child;` naming a default child, entered
+ * together with the state as with \ref hsm_state_set_initial.
+ */
+template <typename Parent = root>
+struct state {
+    using parent = Parent;
+};
+
+namespace detail {
+
+template <typename T>
+struct type_tag {
+    using type = T;
+};
+
+template <typename S>
+constexpr bool is_top = std::is_same_v<typename S::parent, root>;
+
+/* Depth in hierarchy, 0 for top level states */
+template <typename S>
+constexpr uint8_t
+depth() {
+    if constexpr (is_top<S>) {
+        return 0;
+    } else {
+        return depth<typename S::parent>() + 1;
+    }
+}
+
+/* `A` is `S` or one of its ancestors, \ref root is ancestor of every state */
+template <typename A, typename S>
+constexpr bool
+contains() {
+    if constexpr (std::is_same_v<A, root> || std::is_same_v<A, S>) {
+        return true;
+    } else if constexpr (is_top<S>) {
+        return false;
+    } else {
+        return contains<A, typename S::parent>();
+    }
+}
+
+/* Lowest common ancestor, a state is its own ancestor as in the C API */
+template <typename S, typename T>
+constexpr auto
+lca() {
+    if constexpr (contains<S, T>()) {
+        return type_tag<S>{};
+    } else {
+        return lca<typename S::parent, T>();
+    }
+}
+
+template <typename S, typename T>
+using lca_t = typename decltype(lca<S, T>())::type;
+
+/* Leaf reached through `initial` default children, `S` when it has none */
+template <typename S, typename = void>
+struct leaf {
+    using type = S;
+};
+
+template <typename S>
+struct leaf<S, std::void_t<typename S::initial>> {
+    static_assert(std::is_same_v<typename S::initial::parent, S>, "Initial state must be a direct child");
+    using type = typename leaf<typename S::initial>::type;
+};
+
+template <typename S>
+using leaf_t = typename leaf<S>::type;
+
+/* Position of `S` in `States` */
+template <typename S, typename First, typename... Rest>
+constexpr uint8_t
+index_of() {
+    if constexpr (std::is_same_v<S, First>) {
+        return 0;
+    } else {
+        static_assert(sizeof...(Rest) > 0, "State is not part of this machine");
+        return 1 + index_of<S, Rest...>();
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * \brief           State machine with compile-time hierarchy
+ * \tparam          Derived: User machine type deriving from this class, passed to handlers
+ * \tparam          States: All state types of the machine, at most 255
+ */
+template <typename Derived, typename... States>
+class machine {
+  public:
+    using method_fn = void (*)(Derived& m, void* param);
+
+    static_assert(sizeof...(States) > 0 && sizeof...(States) < 0xFF, "Invalid number of states");
+    static_assert(((detail::depth<States>() < HSM_CFG_MAX_DEPTH) && ...),
+                  "State hierarchy deeper than HSM_CFG_MAX_DEPTH");
+
+    /**
+     * \brief           Enter initial state, same semantics as \ref hsm_init
+     * \tparam          Initial: Initial state type
+     * \return          \ref HSM_RES_OK on success
+     */
+    template <typename Initial>
+    hsm_result_t
+    start() {
+        using target = detail::leaf_t<Initial>;
+
+        current_ = detail::index_of<target, States...>();
+        deferred_head_ = 0;
+        deferred_count_ = 0;
+        in_transition_ = 1;
+        enter_from<typename Initial::parent, target>(self(), nullptr);
+        in_transition_ = 0;
+        run_deferred();
+        return HSM_RES_OK;
+    }
+
+    /**
+     * \brief           Dispatch event to current state, same semantics as \ref hsm_dispatch
+     * \param[in]       event: Event to dispatch
+     * \param[in]       data: Event data
+     * \return          \ref HSM_RES_OK on success
+     */
+    hsm_result_t
+    dispatch(hsm_event_t event, void* data = nullptr) {
+        dispatch_table[current_](self(), event, data);
+        return HSM_RES_OK;
+    }
+
+    /**
+     * \brief           Transition to target state, same semantics as \ref hsm_transition
+     * \tparam          Target: Target state type
+     * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
+     * \param[in]       method: Optional hook function called between EXIT and ENTRY
+     * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if deferred
+     *                  transition queue is full
+     */
+    template <typename Target>
+    hsm_result_t
+    transition(void* param = nullptr, method_fn method = nullptr) {
+        if (in_transition_) {
+            if (deferred_count_ >= HSM_CFG_DEFER_SIZE) {
+                return HSM_RES_FULL;
+            }
+            deferred_t& d = deferred_[(deferred_head_ + deferred_count_) % HSM_CFG_DEFER_SIZE];
+            d.run = &machine::run_transition<Target>;
+            d.param = param;
+            d.method = method;
+            deferred_count_++;
+            return HSM_RES_OK;
+        }
+        run_transition<Target>(self(), param, method);
+        run_deferred();
+        return HSM_RES_OK;
+    }
+
+    /**
+     * \brief           Check if machine is in state or one of its substates
+     * \tparam          S: State type to check
+     * \return          `1` if in state, `0` otherwise
+     */
+    template <typename S>
+    uint8_t
+    is_in_state() const {
+        return contains_table<S>[current_];
+    }
+
+    /**
+     * \brief           Get current state index, position in `States`
+     */
+    uint8_t
+    current_index() const {
+        return current_;
+    }
+
+    /**
+     * \brief           Get position of state type in `States`
+     */
+    template <typename S>
+    static constexpr uint8_t
+    index_of() {
+        return detail::index_of<S, States...>();
+    }
+
+  private:
+    using chain_fn = void (*)(Derived& m, hsm_event_t event, void* data);
+    using step_fn = void (*)(Derived& m, void* param, method_fn method);
+
+    struct deferred_t {
+        step_fn run;
+        void* param;
+        method_fn method;
+    };
+
+    Derived&
+    self() {
+        return static_cast<Derived&>(*this);
+    }
+
+    /* Handler chain from `S` up to the top level state */
+    template <typename S>
+    static void
+    chain(Derived& m, hsm_event_t event, void* data) {
+        event = S::handle(m, event, data);
+        if constexpr (!detail::is_top<S>) {
+            if (event != HSM_EVENT_NONE) {
+                chain<typename S::parent>(m, event, data);
+            }
+        }
+    }
+
+    /* EXIT from `S` up to, not including, `Lca` */
+    template <typename S, typename Lca>
+    static void
+    exit_to(Derived& m, void* param) {
+        if constexpr (!std::is_same_v<S, Lca>) {
+            S::handle(m, HSM_EVENT_EXIT, param);
+            exit_to<typename S::parent, Lca>(m, param);
+        }
+    }
+
+    /* ENTRY from below `Lca` down to `T` */
+    template <typename Lca, typename T>
+    static void
+    enter_from(Derived& m, void* param) {
+        if constexpr (!std::is_same_v<T, Lca>) {
+            enter_from<Lca, typename T::parent>(m, param);
+            T::handle(m, HSM_EVENT_ENTRY, param);
+        }
+    }
+
+    /* Fully resolved transition from `S` to `T`, descending to its leaf */
+    template <typename S, typename T>
+    static void
+    step(Derived& m, void* param, method_fn method) {
+        using target = detail::leaf_t<T>;
+        using lca = detail::lca_t<S, target>;
+
+        m.in_transition_ = 1;
+        exit_to<S, lca>(m, param);
+        if (method != nullptr) {
+            method(m, param);
+        }
+        enter_from<lca, target>(m, param);
+        m.current_ = detail::index_of<target, States...>();
+        m.in_transition_ = 0;
+    }
+
+    template <typename T>
+    static void
+    run_transition(Derived& m, void* param, method_fn method) {
+        static constexpr step_fn steps[] = {&machine::step<States, T>...};
+
+        steps[m.current_](m, param, method);
+    }
+
+    void
+    run_deferred() {
+        while (deferred_count_ > 0) {
+            deferred_t d = deferred_[deferred_head_];
+
+            deferred_head_ = (uint8_t)((deferred_head_ + 1) % HSM_CFG_DEFER_SIZE);
+            deferred_count_--;
+            d.run(self(), d.param, d.method);
+        }
+    }
+
+    static constexpr chain_fn dispatch_table[] = {&machine::chain<States>...};
+
+    template <typename S>
+    static constexpr uint8_t contains_table[] = {detail::contains<S, States>()...};
+
+    uint8_t current_ = 0;
+    uint8_t in_transition_ = 0;
+    uint8_t deferred_head_ = 0;
+    uint8_t deferred_count_ = 0;
+    deferred_t deferred_[HSM_CFG_DEFER_SIZE] = {};
+};
+
+/**
+ * \brief           Non-owning C++ view of a C \ref hsm_t instance
+ *
+ * Offers the runtime part of the \ref machine interface, so application
+ * code can drive C and C++ machines alike while migrating.
+ */
+class c_machine {
+  public:
+    explicit c_machine(hsm_t* hsm) : hsm_(hsm) {}
+
+    hsm_result_t
+    dispatch(hsm_event_t event, void* data = nullptr) {
+        return hsm_dispatch(hsm_, event, data);
+    }
+
+    hsm_result_t
+    transition(const hsm_state_t* target, void* param = nullptr,
+               void (*method)(hsm_t* hsm, void* param) = nullptr) {
+        return hsm_transition(hsm_, target, param, method);
+    }
+
+    uint8_t
+    is_in_state(const hsm_state_t* state) const {
+        return hsm_is_in_state(hsm_, state);
+    }
+
+    hsm_t*
+    get() const {
+        return hsm_;
+    }
+
+  private:
+    hsm_t* hsm_;
+};
+
+} /* namespace hsmpp */
+
+/**
+ * \}
+ */
+
+#endif /* HSM_HPP_HDR_H */
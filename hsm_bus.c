@@ -0,0 +1,229 @@
+/**
+ * \file            hsm_bus.c
+ * \brief           Publish/subscribe bus over HSM event queues
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+#include "hsm_bus.h"
+
+#if HSM_CFG_BUS
+#include "hsm_port.h"
+
+#if !HSM_CFG_QUEUE
+#error "HSM_CFG_BUS requires HSM_CFG_QUEUE"
+#endif
+
+/* Check if event can be published on a bus */
+#define PRV_IS_TOPIC(evt)        ((evt) >= HSM_EVENT_USER && (evt) - HSM_EVENT_USER < HSM_CFG_BUS_TOPICS)
+
+/**
+ * \brief           Find member slot of instance, optionally claiming a free one
+ *
+ * Slots are claimed in order and never released, so the first free slot
+ * ends the search. Concurrent claims are resolved by compare-and-swap.
+ *
+ * \param[in]       bus: Bus to search
+ * \param[in]       hsm: Instance to find
+ * \param[in]       claim: `1` to claim a free slot when not found
+ * \return          Member index, `-1` if not found or bus is full
+ */
+static int32_t
+prv_member(hsm_bus_t* bus, hsm_t* hsm, uint8_t claim) {
+    hsm_t* m;
+
+    for (int32_t i = 0; i < HSM_CFG_BUS_MAX_MEMBERS; ++i) {
+        m = HSM_ATOMIC_LOAD(&bus->members[i]);
+        if (m == NULL) {
+            if (!claim) {
+                return -1;
+            }
+            /* Weak CAS may fail spuriously, retry until slot is taken by anyone */
+            do {
+                if (HSM_ATOMIC_CAS(&bus->members[i], &m, hsm)) {
+                    return i;
+                }
+            } while (m == NULL);
+            /* Lost the slot, `m` is the winner */
+        }
+        if (m == hsm) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \brief           Initialize bus, without members and subscriptions
+ * \param[in]       bus: Bus to initialize
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_bus_init(hsm_bus_t* bus) {
+    if (bus == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (uint32_t i = 0; i < HSM_CFG_BUS_MAX_MEMBERS; ++i) {
+        bus->members[i] = NULL;
+    }
+    for (uint32_t i = 0; i < HSM_CFG_BUS_TOPICS; ++i) {
+        bus->topics[i] = 0;
+    }
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Subscribe instance to event
+ *
+ * The first subscription of an instance makes it a bus member.
+ * Subscribing twice to the same event has no further effect.
+ *
+ * \param[in]       bus: Bus to subscribe on
+ * \param[in]       hsm: Instance receiving the event, its queue must be initialized
+ * \param[in]       event: User event, below `HSM_EVENT_USER + HSM_CFG_BUS_TOPICS`
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if the bus has
+ *                  \ref HSM_CFG_BUS_MAX_MEMBERS other members
+ */
+hsm_result_t
+hsm_bus_subscribe(hsm_bus_t* bus, hsm_t* hsm, hsm_event_t event) {
+    int32_t i;
+
+    if (bus == NULL || hsm == NULL || !PRV_IS_TOPIC(event)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    i = prv_member(bus, hsm, 1);
+    if (i < 0) {
+        return HSM_RES_FULL;
+    }
+    {
+        uint32_t* topic = &bus->topics[event - HSM_EVENT_USER];
+        uint32_t subs = HSM_ATOMIC_LOAD(topic);
+
+        while (!HSM_ATOMIC_CAS(topic, &subs, subs | (uint32_t)(1UL << i))) {}
+    }
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Unsubscribe instance from event
+ *
+ * A publish running concurrently may still deliver one last event.
+ *
+ * \param[in]       bus: Bus to unsubscribe from
+ * \param[in]       hsm: Subscribed instance
+ * \param[in]       event: User event
+ * \return          \ref HSM_RES_OK on success, also when not subscribed
+ */
+hsm_result_t
+hsm_bus_unsubscribe(hsm_bus_t* bus, hsm_t* hsm, hsm_event_t event) {
+    int32_t i;
+
+    if (bus == NULL || hsm == NULL || !PRV_IS_TOPIC(event)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    i = prv_member(bus, hsm, 0);
+    if (i >= 0) {
+        uint32_t* topic = &bus->topics[event - HSM_EVENT_USER];
+        uint32_t subs = HSM_ATOMIC_LOAD(topic);
+
+        while (!HSM_ATOMIC_CAS(topic, &subs, subs & ~(uint32_t)(1UL << i))) {}
+    }
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Post event to every subscriber
+ *
+ * Subscribers receive the event in member order through \ref hsm_post.
+ * The data pointer is shared by all of them and must stay valid until
+ * the last one has dispatched it. Pool payloads (`HSM_CFG_EVENT_POOL`)
+ * get one reference per delivery and the bus takes over the caller's
+ * reference, unless \ref HSM_RES_INVALID_PARAM is returned.
+ *
+ * \param[in]       bus: Bus to publish on
+ * \param[in]       event: User event, below `HSM_EVENT_USER + HSM_CFG_BUS_TOPICS`
+ * \param[in]       data: Event data
+ * \return          \ref HSM_RES_OK when every subscriber received the event, also
+ *                  when there is none, result of the last failed \ref hsm_post otherwise
+ */
+hsm_result_t
+hsm_bus_publish(hsm_bus_t* bus, hsm_event_t event, void* data) {
+    hsm_result_t res = HSM_RES_OK, r;
+    uint32_t subs;
+
+    if (bus == NULL || !PRV_IS_TOPIC(event)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    subs = HSM_ATOMIC_LOAD(&bus->topics[event - HSM_EVENT_USER]);
+    for (uint32_t i = 0; subs != 0; ++i, subs >>= 1) {
+        if ((subs & 1) == 0) {
+            continue;
+        }
+#if HSM_CFG_EVENT_POOL
+        /* Queue owns this reference once the post succeeds */
+        hsm_event_ref(data);
+#endif /* HSM_CFG_EVENT_POOL */
+        r = hsm_post(HSM_ATOMIC_LOAD(&bus->members[i]), event, data);
+        if (r != HSM_RES_OK) {
+#if HSM_CFG_EVENT_POOL
+            hsm_event_release(data);
+#endif /* HSM_CFG_EVENT_POOL */
+            res = r;
+        }
+    }
+#if HSM_CFG_EVENT_POOL
+    hsm_event_release(data);
+#endif /* HSM_CFG_EVENT_POOL */
+    return res;
+}
+
+/**
+ * \brief           Count subscribers of event
+ * \param[in]       bus: Bus to query
+ * \param[in]       event: User event
+ * \return          Number of subscribed instances, `0` for invalid parameters
+ */
+uint32_t
+hsm_bus_subscribers(const hsm_bus_t* bus, hsm_event_t event) {
+    uint32_t subs, count = 0;
+
+    if (bus == NULL || !PRV_IS_TOPIC(event)) {
+        return 0;
+    }
+
+    for (subs = HSM_ATOMIC_LOAD(&bus->topics[event - HSM_EVENT_USER]); subs != 0; subs &= subs - 1) {
+        count++;
+    }
+    return count;
+}
+
+#endif /* HSM_CFG_BUS */
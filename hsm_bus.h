@@ -0,0 +1,95 @@
+/**
+ * \file            hsm_bus.h
+ * \brief           Publish/subscribe bus over HSM event queues
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ * Version:         2.0.0
+ */
+#ifndef HSM_BUS_HDR_H
+#define HSM_BUS_HDR_H
+
+#include "hsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if HSM_CFG_BUS
+
+/**
+ * \defgroup        HSM_BUS Publish/subscribe bus
+ * \brief           Decoupled event delivery between HSM instances
+ *
+ * Instances subscribe to user events on a bus. A published event is
+ * posted to the queue of every subscriber with \ref hsm_post, so it is
+ * dispatched by the subscriber's own \ref hsm_process and never runs
+ * inside the publisher's handler or transition.
+ *
+ * Event data is not copied. With `HSM_CFG_EVENT_POOL`, every delivery
+ * holds its own reference of a pool payload, which returns to the pool
+ * once the last subscriber has dispatched it.
+ *
+ * Publishing and subscribing are lock-free and safe from any task, core
+ * or ISR.
+ *
+ * \{
+ */
+
+#if HSM_CFG_BUS_MAX_MEMBERS < 1 || HSM_CFG_BUS_MAX_MEMBERS > 32
+#error "HSM_CFG_BUS_MAX_MEMBERS must be 1 to 32, subscribers are a 32-bit mask"
+#endif
+
+/**
+ * \brief           Publish/subscribe bus
+ *
+ * Zero-initialised or set up with \ref hsm_bus_init before any other use.
+ * Fields are private to the bus.
+ */
+typedef struct hsm_bus {
+    hsm_t* members[HSM_CFG_BUS_MAX_MEMBERS];  /*!< Instances that subscribed, in claim order */
+    uint32_t topics[HSM_CFG_BUS_TOPICS];      /*!< Subscribed members per event, bit per member */
+} hsm_bus_t;
+
+hsm_result_t hsm_bus_init(hsm_bus_t* bus);
+hsm_result_t hsm_bus_subscribe(hsm_bus_t* bus, hsm_t* hsm, hsm_event_t event);
+hsm_result_t hsm_bus_unsubscribe(hsm_bus_t* bus, hsm_t* hsm, hsm_event_t event);
+hsm_result_t hsm_bus_publish(hsm_bus_t* bus, hsm_event_t event, void* data);
+uint32_t hsm_bus_subscribers(const hsm_bus_t* bus, hsm_event_t event);
+
+/**
+ * \}
+ */
+
+#endif /* HSM_CFG_BUS */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HSM_BUS_HDR_H */
@@ -48,7 +48,50 @@
 #include "sdkconfig.h"
 
 #define HSM_CFG_MAX_DEPTH CONFIG_HSM_MAX_DEPTH
+#define HSM_CFG_DEFER_SIZE CONFIG_HSM_DEFER_SIZE
+#define HSM_CFG_PARAM_CHECK CONFIG_HSM_PARAM_CHECK
 #define HSM_CFG_HISTORY CONFIG_HSM_HISTORY
+#define HSM_CFG_INITIAL CONFIG_HSM_INITIAL
+#define HSM_CFG_STATE_HISTORY CONFIG_HSM_STATE_HISTORY
+#define HSM_CFG_HISTORY_SLOTS CONFIG_HSM_HISTORY_SLOTS
+#define HSM_CFG_REGIONS CONFIG_HSM_REGIONS
+#define HSM_CFG_SNAPSHOT CONFIG_HSM_SNAPSHOT
+#define HSM_CFG_COMPILED CONFIG_HSM_COMPILED
+#define HSM_CFG_QUEUE CONFIG_HSM_QUEUE
+#define HSM_CFG_QUEUE_URGENT CONFIG_HSM_QUEUE_URGENT
+#define HSM_CFG_EVENT_POOL CONFIG_HSM_EVENT_POOL
+#define HSM_CFG_EVENT_POOL_SIZE CONFIG_HSM_EVENT_POOL_SIZE
+#define HSM_CFG_EVENT_POOL_SMALL CONFIG_HSM_EVENT_POOL_SMALL
+#define HSM_CFG_EVENT_POOL_MEDIUM CONFIG_HSM_EVENT_POOL_MEDIUM
+#define HSM_CFG_EVENT_POOL_LARGE CONFIG_HSM_EVENT_POOL_LARGE
+#define HSM_CFG_TRACE CONFIG_HSM_TRACE
+#define HSM_CFG_TRACE_HISTOGRAM CONFIG_HSM_TRACE_HISTOGRAM
+#define HSM_CFG_TRACE_HISTOGRAM_BINS CONFIG_HSM_TRACE_HISTOGRAM_BINS
+#define HSM_CFG_TRACE_RING CONFIG_HSM_TRACE_RING
+#define HSM_CFG_TRACE_RING_SIZE CONFIG_HSM_TRACE_RING_SIZE
+#define HSM_CFG_TRACE_RING_NAMES CONFIG_HSM_TRACE_RING_NAMES
+#define HSM_CFG_EVENT_MASK CONFIG_HSM_EVENT_MASK
+#define HSM_CFG_EVENT_MASK_BITS CONFIG_HSM_EVENT_MASK_BITS
+#define HSM_CFG_EVENT_TABLE CONFIG_HSM_EVENT_TABLE
+#define HSM_CFG_GUARDS CONFIG_HSM_GUARDS
+#define HSM_CFG_EVENT_DEFER CONFIG_HSM_EVENT_DEFER
+#define HSM_CFG_EVENT_DEFER_SIZE CONFIG_HSM_EVENT_DEFER_SIZE
+#define HSM_CFG_TABLE CONFIG_HSM_TABLE
+#define HSM_CFG_TABLE_BLOB CONFIG_HSM_TABLE_BLOB
+#define HSM_CFG_TABLE_POOL CONFIG_HSM_TABLE_POOL
+#define HSM_CFG_TABLE_POOL_ALIGN CONFIG_HSM_TABLE_POOL_ALIGN
+#define HSM_CFG_SCHED CONFIG_HSM_SCHED
+#define HSM_CFG_SCHED_MAX_WORKERS CONFIG_HSM_SCHED_MAX_WORKERS
+#define HSM_CFG_SCHED_BUDGET CONFIG_HSM_SCHED_BUDGET
+#define HSM_CFG_TIMER CONFIG_HSM_TIMER
+#define HSM_CFG_TIMER_BITS CONFIG_HSM_TIMER_BITS
+#define HSM_CFG_TIMER_LEVELS CONFIG_HSM_TIMER_LEVELS
+#define HSM_CFG_ASYNC CONFIG_HSM_ASYNC
+#define HSM_CFG_STATS CONFIG_HSM_STATS
+#define HSM_CFG_UNHANDLED CONFIG_HSM_UNHANDLED
+#define HSM_CFG_BUS CONFIG_HSM_BUS
+#define HSM_CFG_BUS_TOPICS CONFIG_HSM_BUS_TOPICS
+#define HSM_CFG_BUS_MAX_MEMBERS CONFIG_HSM_BUS_MAX_MEMBERS
 
 #else
 /**
@@ -64,6 +107,34 @@
 #define HSM_CFG_MAX_DEPTH 8
 #endif
 
+/**
+ * \brief           Deferred transition queue size
+ *
+ * Transitions requested from ENTRY/EXIT handlers are queued with their
+ * parameter and method, then executed in order once the running transition
+ * completes. Each entry uses 3 pointers in the HSM instance; requests beyond
+ * this size are rejected with \ref HSM_RES_FULL.
+ *
+ * Range: 1-255
+ * Default: 2
+ */
+#ifndef HSM_CFG_DEFER_SIZE
+#define HSM_CFG_DEFER_SIZE 2
+#endif
+
+/**
+ * \brief           Check parameters of hot path functions
+ *
+ * When disabled, hsm_dispatch(), hsm_dispatch_batch(), hsm_dispatch_fanout()
+ * and hsm_transition() skip their `NULL` checks. Only disable for machines checked with hsm_validate() and
+ * instances that are always initialized.
+ *
+ * Default: 1 (enabled)
+ */
+#ifndef HSM_CFG_PARAM_CHECK
+#define HSM_CFG_PARAM_CHECK 1
+#endif
+
 /**
  * \brief           Enable state history feature
  * 
@@ -78,6 +149,616 @@
 #define HSM_CFG_HISTORY 1
 #endif
 
+/**
+ * \brief           Enable initial (default child) states
+ *
+ * When enabled, a composite state can name a default child with
+ * hsm_state_set_initial(). hsm_init() and hsm_transition() then descend
+ * through default children to a leaf in the same entry sequence, instead
+ * of a second transition requested from the ENTRY handler.
+ *
+ * Adds 4 bytes to state structure size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_INITIAL
+#define HSM_CFG_INITIAL 0
+#endif
+
+/**
+ * \brief           Enable per-state shallow and deep history
+ *
+ * When enabled, history pseudo-states created with hsm_state_create_history()
+ * can be targeted by hsm_transition() to resume a composite state where
+ * it was left, in one transition. The active leaf is recorded in the HSM
+ * instance when the composite state is exited, state structures are not
+ * written and can be shared by many instances.
+ *
+ * Adds 2 bytes to state structure size and \ref HSM_CFG_HISTORY_SLOTS
+ * times 2 pointers to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_STATE_HISTORY
+#define HSM_CFG_STATE_HISTORY 0
+#endif
+
+/**
+ * \brief           Number of composite states with history per HSM instance
+ *
+ * History of further composite states is not recorded, their history
+ * pseudo-states enter the composite state itself.
+ *
+ * Requires \ref HSM_CFG_STATE_HISTORY.
+ *
+ * Default: 4
+ */
+#ifndef HSM_CFG_HISTORY_SLOTS
+#define HSM_CFG_HISTORY_SLOTS 4
+#endif
+
+/**
+ * \brief           Enable orthogonal regions
+ *
+ * When enabled, hsm_region_add() attaches separate HSM instances to
+ * a composite state. Regions are entered and exited together with the
+ * composite and see every event before the owning instance.
+ *
+ * Adds 4 pointers and 1 byte to HSM structure size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_REGIONS
+#define HSM_CFG_REGIONS 0
+#endif
+
+/**
+ * \brief           Enable snapshot and restore
+ *
+ * When enabled, hsm_snapshot() saves current, initial and history states
+ * and deferred events of an instance and its regions, plus queued events,
+ * into a small buffer, using positions in a state set instead of pointers,
+ * and hsm_restore() brings an instance back into that configuration
+ * without running ENTRY handlers. Armed timers are not saved.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_SNAPSHOT
+#define HSM_CFG_SNAPSHOT 0
+#endif
+
+/**
+ * \brief           Enable compiled transition tables
+ *
+ * When enabled, \ref hsm_compile() can precompute the ancestor paths
+ * and common ancestor of every (source, target) pair of a state set.
+ * Transitions between compiled states become a table lookup and
+ * flat loops of EXIT and ENTRY calls, without LCA computation.
+ *
+ * Adds 1 byte to state size and 4 bytes to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_COMPILED
+#define HSM_CFG_COMPILED 0
+#endif
+
+/**
+ * \brief           Enable posted event queue
+ *
+ * When enabled, each HSM instance can be given a lock-free
+ * multi-producer single-consumer ring with \ref hsm_queue_init().
+ * Events are posted from any task, core or ISR with \ref hsm_post()
+ * and dispatched with run-to-completion semantics by \ref hsm_process()
+ * on the task owning the HSM.
+ *
+ * Requires atomic operations, see `hsm_port.h`.
+ * Adds 20 bytes to HSM instance size, plus application provided slots.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_QUEUE
+#define HSM_CFG_QUEUE 0
+#endif
+
+/**
+ * \brief           Enable urgent lane of the event queue
+ *
+ * When enabled, \ref hsm_queue_init_urgent() assigns a second ring to an
+ * instance. Events posted with \ref hsm_post_urgent() are dispatched
+ * before every event of the normal queue.
+ *
+ * Requires \ref HSM_CFG_QUEUE.
+ * Adds 28 bytes to HSM instance size, plus application provided slots.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_QUEUE_URGENT
+#define HSM_CFG_QUEUE_URGENT 0
+#endif
+
+/**
+ * \brief           Enable static event payload pool
+ *
+ * When enabled, \ref hsm_event_alloc() hands out reference counted
+ * payload blocks from statically allocated storage in three size classes.
+ * Pool payloads posted with \ref hsm_post() are released automatically
+ * once the event has been dispatched. No heap is used.
+ *
+ * Requires atomic operations, see `hsm_port.h`.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_EVENT_POOL
+#define HSM_CFG_EVENT_POOL 0
+#endif
+
+/**
+ * \brief           Number of blocks in each event pool size class
+ *
+ * Range: 1-1024
+ * Default: 8
+ */
+#ifndef HSM_CFG_EVENT_POOL_SIZE
+#define HSM_CFG_EVENT_POOL_SIZE 8
+#endif
+
+/**
+ * \brief           Payload size of small event pool blocks, in bytes
+ *
+ * Each block adds 8 bytes of header.
+ * Set to 0 to disable the size class.
+ *
+ * Default: 16
+ */
+#ifndef HSM_CFG_EVENT_POOL_SMALL
+#define HSM_CFG_EVENT_POOL_SMALL 16
+#endif
+
+/**
+ * \brief           Payload size of medium event pool blocks, in bytes
+ *
+ * Must be larger than \ref HSM_CFG_EVENT_POOL_SMALL,
+ * set to 0 to disable the size class.
+ *
+ * Default: 64
+ */
+#ifndef HSM_CFG_EVENT_POOL_MEDIUM
+#define HSM_CFG_EVENT_POOL_MEDIUM 64
+#endif
+
+/**
+ * \brief           Payload size of large event pool blocks, in bytes
+ *
+ * Must be larger than \ref HSM_CFG_EVENT_POOL_MEDIUM,
+ * set to 0 to disable the size class.
+ *
+ * Default: 256
+ */
+#ifndef HSM_CFG_EVENT_POOL_LARGE
+#define HSM_CFG_EVENT_POOL_LARGE 256
+#endif
+
+/**
+ * \brief           Enable dispatch path tracing
+ *
+ * When enabled, the engine calls the function named by `HSM_CFG_TRACE_HOOK`
+ * at dispatch begin and end, every handler invocation, every EXIT
+ * and ENTRY step, transition begin and end and every deferred
+ * transition, see \ref hsm_trace_type_t. Define the hook name in the
+ * build system, e.g. `-DHSM_CFG_TRACE_HOOK=app_trace_hook`, the prototype
+ * is declared by `hsm.h`.
+ *
+ * When disabled, all trace points compile to nothing.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TRACE
+#define HSM_CFG_TRACE 0
+#endif
+
+/**
+ * \brief           Enable built-in latency histogram collector
+ *
+ * When enabled together with \ref HSM_CFG_TRACE, cycle counts from
+ * `HSM_PORT_CYCLES()` are recorded into log2 histograms: per state slot
+ * for handler invocations, per HSM instance for dispatch and transition.
+ *
+ * Adds `4 * HSM_CFG_TRACE_HISTOGRAM_BINS` bytes to state slot size,
+ * twice that to HSM instance size and 2 bytes to state size.
+ *
+ * Default: 1 (enabled)
+ */
+#ifndef HSM_CFG_TRACE_HISTOGRAM
+#define HSM_CFG_TRACE_HISTOGRAM 1
+#endif
+
+/**
+ * \brief           Number of latency histogram bins
+ *
+ * Bin `n` counts samples in range `[2^n, 2^(n+1))` cycles,
+ * the last bin also collects everything above.
+ *
+ * Range: 4-32
+ * Default: 24
+ */
+#ifndef HSM_CFG_TRACE_HISTOGRAM_BINS
+#define HSM_CFG_TRACE_HISTOGRAM_BINS 24
+#endif
+
+/**
+ * \brief           Enable binary trace ring buffer
+ *
+ * When enabled together with \ref HSM_CFG_TRACE, every trace point
+ * stores a 12 byte record (timestamp, event, state id, HSM id, type)
+ * into a lock-free ring, without any formatting. States and HSM instances
+ * get sequential ids at creation and their names are kept in a small table,
+ * so \ref hsm_trace_ring_dump() output can be decoded on the host with
+ * `tools/hsm_trace_decode.c`.
+ *
+ * Requires atomic operations, see `hsm_port.h`.
+ * Adds 2 bytes to state size and 1 byte to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TRACE_RING
+#define HSM_CFG_TRACE_RING 0
+#endif
+
+/**
+ * \brief           Number of records in trace ring buffer
+ *
+ * Must be a power of two.
+ *
+ * Default: 256
+ */
+#ifndef HSM_CFG_TRACE_RING_SIZE
+#define HSM_CFG_TRACE_RING_SIZE 256
+#endif
+
+/**
+ * \brief           Number of state and HSM names kept for trace decoding
+ *
+ * States and HSM instances with ids above this limit are traced
+ * by id only. Ids are kept per state and instance structure, so
+ * re-creating, re-initialising or restoring them uses no new id.
+ *
+ * Range: 1-65535
+ * Default: 64
+ */
+#ifndef HSM_CFG_TRACE_RING_NAMES
+#define HSM_CFG_TRACE_RING_NAMES 64
+#endif
+
+/**
+ * \brief           Enable per-state event masks
+ *
+ * When enabled, \ref hsm_state_create_ex() declares which user events
+ * a state handles. \ref hsm_dispatch() skips handlers of states that
+ * do not handle the event, instead of calling them to fall through.
+ * Events outside the mask range are always delivered.
+ *
+ * Adds `HSM_CFG_EVENT_MASK_BITS / 8` bytes to state size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_EVENT_MASK
+#define HSM_CFG_EVENT_MASK 0
+#endif
+
+/**
+ * \brief           Width of event masks in bits
+ *
+ * Bit `n` covers event `HSM_EVENT_USER + n`.
+ *
+ * Range: 32 or 64
+ * Default: 32
+ */
+#ifndef HSM_CFG_EVENT_MASK_BITS
+#define HSM_CFG_EVENT_MASK_BITS 32
+#endif
+
+/**
+ * \brief           Enable per-state event tables
+ *
+ * When enabled, \ref hsm_state_set_table() attaches a dense array of
+ * action and target entries to a state, indexed by event. Dispatch
+ * resolves table events with one bounds check instead of a handler
+ * `switch`, and can transition without any handler code.
+ *
+ * Adds 1 pointer and 6 bytes to state size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_EVENT_TABLE
+#define HSM_CFG_EVENT_TABLE 0
+#endif
+
+/**
+ * \brief           Enable declarative guarded transitions
+ *
+ * When enabled, \ref hsm_state_set_transitions() attaches a list of
+ * event, guard, target and action entries to a state. Dispatch takes
+ * the first matching transition directly, without calling the state
+ * handler.
+ *
+ * Adds 1 pointer and 1 byte to state size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_GUARDS
+#define HSM_CFG_GUARDS 0
+#endif
+
+/**
+ * \brief           Enable per-state event deferral
+ *
+ * When enabled, \ref hsm_state_set_defer() lists user events a state
+ * postpones. Postponed events are kept in a store of each instance and
+ * dispatched again after a state with a deferral mask is exited.
+ * Shares mask width with \ref HSM_CFG_EVENT_MASK_BITS.
+ *
+ * Adds `HSM_CFG_EVENT_MASK_BITS / 8` bytes to state size and
+ * `HSM_CFG_EVENT_DEFER_SIZE` events to HSM structure size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_EVENT_DEFER
+#define HSM_CFG_EVENT_DEFER 0
+#endif
+
+/**
+ * \brief           Number of events the deferred store holds per instance
+ *
+ * When the store is full, events are handled as if not deferred.
+ *
+ * Range: 1-255
+ * Default: 8
+ */
+#ifndef HSM_CFG_EVENT_DEFER_SIZE
+#define HSM_CFG_EVENT_DEFER_SIZE 8
+#endif
+
+/**
+ * \brief           Enable compact state table mode
+ *
+ * When enabled, `hsm_table.h` provides machines defined by one
+ * contiguous `const` array of states with `uint8_t` parent and handler
+ * indices, placeable in flash. Instances track the current state
+ * as an index and take 4 bytes plus a pointer of RAM.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TABLE
+#define HSM_CFG_TABLE 0
+#endif
+
+/**
+ * \brief           Enable serialised table definitions
+ *
+ * When enabled, hsm_table_load() binds a table mode machine stored as a
+ * binary blob (flash, memory mapped file) to a handler array without
+ * copying, and hsm_table_save() produces such blobs.
+ *
+ * Requires \ref HSM_CFG_TABLE.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TABLE_BLOB
+#define HSM_CFG_TABLE_BLOB 0
+#endif
+
+/**
+ * \brief           Enable table mode instance pools
+ *
+ * When enabled, hsm_table_pool_init() manages many instances of one
+ * table definition with one byte of RAM each, stored in a dense array,
+ * and hsm_table_pool_broadcast() dispatches an event to a range of
+ * them in one linear pass.
+ *
+ * Requires \ref HSM_CFG_TABLE.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TABLE_POOL
+#define HSM_CFG_TABLE_POOL 0
+#endif
+
+/**
+ * \brief           Shard alignment of instance pools in bytes
+ *
+ * hsm_table_pool_shard() splits pools on multiples of this value,
+ * set to the data cache line size of the target.
+ *
+ * Must be a power of two.
+ * Default: 64
+ */
+#ifndef HSM_CFG_TABLE_POOL_ALIGN
+#define HSM_CFG_TABLE_POOL_ALIGN 64
+#endif
+
+/**
+ * \brief           Enable multi-instance scheduler
+ *
+ * When enabled, `hsm_sched.h` runs many queued HSM instances on a pool
+ * of application created worker tasks, with work stealing and the
+ * guarantee that one instance is never processed by two workers at once.
+ *
+ * Requires \ref HSM_CFG_QUEUE.
+ * Adds 8 bytes to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_SCHED
+#define HSM_CFG_SCHED 0
+#endif
+
+/**
+ * \brief           Maximum number of scheduler workers
+ *
+ * Range: 1-255
+ * Default: 4
+ */
+#ifndef HSM_CFG_SCHED_MAX_WORKERS
+#define HSM_CFG_SCHED_MAX_WORKERS 4
+#endif
+
+/**
+ * \brief           Events dispatched per instance turn
+ *
+ * A busy instance is re-queued behind other ready instances
+ * after this many events.
+ *
+ * Default: 8
+ */
+#ifndef HSM_CFG_SCHED_BUDGET
+#define HSM_CFG_SCHED_BUDGET 8
+#endif
+
+/**
+ * \brief           Enable timer wheel
+ *
+ * When enabled, `hsm_timer.h` provides one-shot and periodic time events
+ * kept in a hierarchical timer wheel advanced by \ref hsm_timer_tick.
+ * Expired events are posted to the instance queue, timers bound to a
+ * state are cancelled when it is exited. Define `HSM_CFG_TIMER_LOCK()`
+ * and `HSM_CFG_TIMER_UNLOCK()` in the build system when the wheel is
+ * used from more than one task.
+ *
+ * Requires \ref HSM_CFG_QUEUE.
+ * Adds 1 pointer to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_TIMER
+#define HSM_CFG_TIMER 0
+#endif
+
+/**
+ * \brief           Slot index width of one timer wheel level
+ *
+ * Each level has `2^HSM_CFG_TIMER_BITS` slots.
+ *
+ * Range: 2-8
+ * Default: 6
+ */
+#ifndef HSM_CFG_TIMER_BITS
+#define HSM_CFG_TIMER_BITS 6
+#endif
+
+/**
+ * \brief           Number of timer wheel levels
+ *
+ * Delays up to `2^(HSM_CFG_TIMER_BITS * HSM_CFG_TIMER_LEVELS)` ticks are
+ * placed directly, longer ones are re-placed when the last level turns.
+ *
+ * Range: 1-8
+ * Default: 4
+ */
+#ifndef HSM_CFG_TIMER_LEVELS
+#define HSM_CFG_TIMER_LEVELS 4
+#endif
+
+/**
+ * \brief           Enable asynchronous ENTRY handlers
+ *
+ * When enabled, an ENTRY handler may return \ref HSM_EVENT_PENDING to
+ * suspend the transition in its state. Following events go to that
+ * handler only, which returns `HSM_EVENT_PENDING` to keep waiting,
+ * \ref HSM_EVENT_NONE to complete the entry or the event to postpone it
+ * (with \ref HSM_CFG_EVENT_DEFER, dropped otherwise). Transitions
+ * requested meanwhile run once the suspended one completes.
+ *
+ * Adds 3 pointers to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_ASYNC
+#define HSM_CFG_ASYNC 0
+#endif
+
+/**
+ * \brief           Enable statistics counters
+ *
+ * When enabled, every state counts its entries, exits, and events it
+ * handled or propagated, every instance counts dispatches, transitions,
+ * unhandled events, deferred transitions and the deepest posted queue
+ * seen. Counters are 32-bit atomics, they can be read and cleared from
+ * another task (\ref hsm_stats_get, \ref hsm_state_stats_get) while
+ * the machine runs.
+ *
+ * State counters live in the instance state slots attached with
+ * \ref hsm_set_state_slots, dispatch does not write state structures.
+ *
+ * Adds 16 bytes to state slot size, 2 bytes to state size and 28 bytes
+ * to HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_STATS
+#define HSM_CFG_STATS 0
+#endif
+
+/**
+ * \brief           Enable unhandled event reporting
+ *
+ * When enabled, \ref hsm_dispatch() returns \ref HSM_RES_UNHANDLED for
+ * events no state consumed and calls the callback set with
+ * \ref hsm_set_unhandled(). With \ref HSM_CFG_EVENT_MASK, the union of
+ * handled and deferred events of the active state chain is cached per
+ * current state, user events outside it are rejected before any handler
+ * runs.
+ *
+ * Adds 1 pointer to HSM instance size, plus 1 pointer, 4 bytes and
+ * `HSM_CFG_EVENT_MASK_BITS / 8` bytes with \ref HSM_CFG_EVENT_MASK.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_UNHANDLED
+#define HSM_CFG_UNHANDLED 0
+#endif
+
+/**
+ * \brief           Enable publish/subscribe bus
+ *
+ * When enabled, `hsm_bus.h` lets instances subscribe to user events and
+ * publishers post an event once to every subscriber queue, instead of
+ * dispatching into other instances directly. Payloads are shared, pool
+ * payloads are reference counted per delivery.
+ *
+ * Requires \ref HSM_CFG_QUEUE.
+ * Does not change HSM instance size.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef HSM_CFG_BUS
+#define HSM_CFG_BUS 0
+#endif
+
+/**
+ * \brief           Number of publishable events per bus
+ *
+ * Events `HSM_EVENT_USER` to `HSM_EVENT_USER + HSM_CFG_BUS_TOPICS - 1`
+ * can be published. Each one adds 4 bytes to bus size.
+ *
+ * Default: 32
+ */
+#ifndef HSM_CFG_BUS_TOPICS
+#define HSM_CFG_BUS_TOPICS 32
+#endif
+
+/**
+ * \brief           Maximum number of instances subscribed to one bus
+ *
+ * Subscribers of an event are kept as one bit per member in a 32-bit
+ * word, so at most 32. Each member adds one pointer to bus size.
+ *
+ * Default: 32
+ */
+#ifndef HSM_CFG_BUS_MAX_MEMBERS
+#define HSM_CFG_BUS_MAX_MEMBERS 32
+#endif
+
 #endif /* HSM_CFG_USE_KCONFIG */
 
 #endif /* HSM_CONFIG_HDR_H */
@@ -0,0 +1,119 @@
+/**
+ * \file            hsm_port.h
+ * \brief           HSM platform abstraction
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+#ifndef HSM_PORT_HDR_H
+#define HSM_PORT_HDR_H
+
+#include <stdint.h>
+
+/*
+ * Library internal header, used only by HSM source files.
+ *
+ * Every macro can be overridden by defining it before this file is
+ * included (for example from the build system), when the compiler
+ * does not provide GCC compatible atomic builtins.
+ */
+
+/**
+ * \defgroup        HSM_PORT_ATOMIC Atomic operations
+ * \brief           Lock-free primitives on 32-bit words
+ * \{
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#ifndef HSM_ATOMIC_LOAD
+#define HSM_ATOMIC_LOAD(ptr)                __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#endif
+
+#ifndef HSM_ATOMIC_STORE
+#define HSM_ATOMIC_STORE(ptr, val)          __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#endif
+
+/* Weak compare-and-swap, updates `*exp` with current value on failure */
+#ifndef HSM_ATOMIC_CAS
+#define HSM_ATOMIC_CAS(ptr, exp, val)                                                              \
+    __atomic_compare_exchange_n((ptr), (exp), (val), 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#endif
+
+/* Returns value before the addition */
+#ifndef HSM_ATOMIC_FETCH_ADD
+#define HSM_ATOMIC_FETCH_ADD(ptr, val)      __atomic_fetch_add((ptr), (val), __ATOMIC_ACQ_REL)
+#endif
+
+#endif /* defined(__GNUC__) || defined(__clang__) */
+
+#if !defined(HSM_ATOMIC_LOAD) || !defined(HSM_ATOMIC_STORE) || !defined(HSM_ATOMIC_CAS)                \
+    || !defined(HSM_ATOMIC_FETCH_ADD)
+#error "HSM: atomic operations are not available for this compiler, define HSM_ATOMIC_* macros"
+#endif
+
+/**
+ * \}
+ */
+
+/**
+ * \defgroup        HSM_PORT_CYCLES Cycle counter
+ * \brief           Free running 32-bit timestamp used by tracing
+ * \{
+ */
+
+#ifndef HSM_PORT_CYCLES
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define HSM_PORT_CYCLES()                   ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#define HSM_PORT_CYCLES()                   ((uint32_t)esp_cpu_get_ccount())
+#endif
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+/* DWT->CYCCNT, application must enable the DWT cycle counter */
+#define HSM_PORT_CYCLES()                   (*(volatile uint32_t*)0xE0001004UL)
+#else
+#include <time.h>
+/* Hosted fallback, nanoseconds instead of cycles */
+static inline uint32_t
+hsm_port_cycles(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define HSM_PORT_CYCLES()                   hsm_port_cycles()
+#endif
+#endif /* HSM_PORT_CYCLES */
+
+/**
+ * \}
+ */
+
+#endif /* HSM_PORT_HDR_H */
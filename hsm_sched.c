@@ -0,0 +1,299 @@
+/**
+ * \file            hsm_sched.c
+ * \brief           Multi-instance HSM scheduler implementation
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+#include "hsm_sched.h"
+
+#if HSM_CFG_SCHED
+#include "hsm_port.h"
+
+#if !HSM_CFG_QUEUE
+#error "HSM_CFG_SCHED requires HSM_CFG_QUEUE"
+#endif
+
+/* Instance scheduling states */
+#define PRV_IDLE                 0            /* No pending work */
+#define PRV_QUEUED               1            /* In a run queue */
+#define PRV_RUNNING              2            /* Being processed by a worker */
+#define PRV_RUNNING_DIRTY        3            /* Being processed, new events arrived */
+
+/**
+ * \brief           Push instance to run queue
+ * \param[in]       r: Run queue
+ * \param[in]       hsm: Instance to push
+ * \return          `1` on success, `0` if run queue is full
+ */
+static uint8_t
+prv_ring_push(hsm_sched_ring_t* r, hsm_t* hsm) {
+    hsm_sched_slot_t* slot;
+    uint32_t pos = HSM_ATOMIC_LOAD(&r->head);
+    int32_t diff;
+
+    for (;;) {
+        slot = &r->slots[pos & r->mask];
+        diff = (int32_t)(HSM_ATOMIC_LOAD(&slot->seq) - pos);
+        if (diff == 0) {
+            if (HSM_ATOMIC_CAS(&r->head, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = HSM_ATOMIC_LOAD(&r->head);
+        }
+    }
+    slot->hsm = hsm;
+    HSM_ATOMIC_STORE(&slot->seq, pos + 1);
+    return 1;
+}
+
+/**
+ * \brief           Pop instance from run queue
+ * \param[in]       r: Run queue
+ * \return          Instance, `NULL` if run queue is empty
+ */
+static hsm_t*
+prv_ring_pop(hsm_sched_ring_t* r) {
+    hsm_sched_slot_t* slot;
+    hsm_t* hsm;
+    uint32_t pos = HSM_ATOMIC_LOAD(&r->tail);
+    int32_t diff;
+
+    for (;;) {
+        slot = &r->slots[pos & r->mask];
+        diff = (int32_t)(HSM_ATOMIC_LOAD(&slot->seq) - (pos + 1));
+        if (diff == 0) {
+            if (HSM_ATOMIC_CAS(&r->tail, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = HSM_ATOMIC_LOAD(&r->tail);
+        }
+    }
+    hsm = slot->hsm;
+    HSM_ATOMIC_STORE(&slot->seq, pos + r->mask + 1);
+    return hsm;
+}
+
+/**
+ * \brief           Put queued instance on a run queue and wake the worker
+ *
+ * Starts with the instance home worker. Total run queue capacity is at
+ * least the number of attached instances and every instance is queued at
+ * most once, so a free slot always exists.
+ *
+ * \param[in]       sched: Pointer to scheduler
+ * \param[in]       hsm: Instance in \ref PRV_QUEUED state
+ */
+static void
+prv_enqueue(hsm_sched_t* sched, hsm_t* hsm) {
+    uint8_t i, w;
+
+    for (;;) {
+        for (i = 0; i < sched->workers; i++) {
+            w = (uint8_t)((hsm->sched_home + i) % sched->workers);
+            if (prv_ring_push(&sched->rings[w], hsm)) {
+                if (sched->notify != NULL) {
+                    sched->notify(sched, w, sched->notify_arg);
+                }
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Mark instance ready after an event was posted
+ * \param[in]       hsm: Instance that received an event
+ * \param[in]       arg: Pointer to scheduler
+ */
+static void
+prv_ready(hsm_t* hsm, void* arg) {
+    uint32_t state = HSM_ATOMIC_LOAD(&hsm->sched_state);
+
+    for (;;) {
+        if (state == PRV_IDLE) {
+            if (HSM_ATOMIC_CAS(&hsm->sched_state, &state, PRV_QUEUED)) {
+                prv_enqueue((hsm_sched_t*)arg, hsm);
+                return;
+            }
+        } else if (state == PRV_RUNNING) {
+            /* Worker re-queues the instance when it finishes */
+            if (HSM_ATOMIC_CAS(&hsm->sched_state, &state, PRV_RUNNING_DIRTY)) {
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * \brief           Initialize scheduler
+ * \param[in]       sched: Pointer to scheduler
+ * \param[in]       slots: Run queue storage of `workers * slots_per_worker` slots
+ * \param[in]       slots_per_worker: Run queue size per worker, must be a power of two
+ * \param[in]       workers: Number of workers, up to `HSM_CFG_SCHED_MAX_WORKERS`
+ * \param[in]       notify: Worker wake-up function, can be `NULL`
+ * \param[in]       arg: User argument passed to `notify`
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_sched_init(hsm_sched_t* sched, hsm_sched_slot_t* slots, uint32_t slots_per_worker, uint8_t workers,
+               hsm_sched_notify_fn notify, void* arg) {
+    uint32_t i;
+    uint8_t w;
+
+    if (sched == NULL || slots == NULL || workers == 0 || workers > HSM_CFG_SCHED_MAX_WORKERS
+        || slots_per_worker < 2 || (slots_per_worker & (slots_per_worker - 1)) != 0) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (w = 0; w < workers; w++) {
+        hsm_sched_ring_t* r = &sched->rings[w];
+
+        r->slots = &slots[w * slots_per_worker];
+        r->mask = slots_per_worker - 1;
+        r->head = 0;
+        r->tail = 0;
+        for (i = 0; i < slots_per_worker; i++) {
+            r->slots[i].seq = i;
+            r->slots[i].hsm = NULL;
+        }
+    }
+    sched->workers = workers;
+    sched->next_home = 0;
+    sched->capacity = slots_per_worker * workers;
+    sched->attached = 0;
+    sched->notify = notify;
+    sched->notify_arg = arg;
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Attach HSM instance to scheduler
+ *
+ * The instance must have its queue initialized with \ref hsm_queue_init.
+ * From now on every \ref hsm_post schedules the instance, it must no
+ * longer be processed directly by the application. Home workers are
+ * assigned round-robin.
+ *
+ * \param[in]       sched: Pointer to scheduler
+ * \param[in]       hsm: Instance to attach
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if run queue
+ *                  capacity is exhausted
+ */
+hsm_result_t
+hsm_sched_attach(hsm_sched_t* sched, hsm_t* hsm) {
+    if (sched == NULL || hsm == NULL || hsm->queue.slots == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    if (sched->attached >= sched->capacity) {
+        return HSM_RES_FULL;
+    }
+
+    sched->attached++;
+    hsm->sched_home = sched->next_home;
+    sched->next_home = (uint8_t)((sched->next_home + 1) % sched->workers);
+    HSM_ATOMIC_STORE(&hsm->sched_state, PRV_IDLE);
+    hsm_queue_set_notify(hsm, prv_ready, sched);
+#if HSM_CFG_QUEUE_URGENT
+    /* Urgent posts schedule the instance too */
+    hsm_queue_set_notify_urgent(hsm, NULL, NULL);
+#endif /* HSM_CFG_QUEUE_URGENT */
+
+    /* Events posted before attaching */
+    if (hsm_queue_pending(hsm)) {
+        prv_ready(hsm, sched);
+    }
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Run ready instances on a worker
+ *
+ * Processes instances from the worker's own run queue, then steals from
+ * the other workers, until no ready instance is left. Each instance turn
+ * dispatches at most `HSM_CFG_SCHED_BUDGET` events, with run-to-completion
+ * semantics, before the instance is re-queued behind the others.
+ *
+ * \param[in]       sched: Pointer to scheduler
+ * \param[in]       worker: Calling worker index
+ * \return          Number of instance turns run, `0` when idle
+ */
+uint32_t
+hsm_sched_poll(hsm_sched_t* sched, uint8_t worker) {
+    hsm_t* hsm;
+    uint32_t turns = 0, state;
+    uint8_t i, idle;
+
+    if (sched == NULL || worker >= sched->workers) {
+        return 0;
+    }
+
+    for (;;) {
+        /* Own run queue first, then steal */
+        hsm = NULL;
+        for (i = 0; i < sched->workers && hsm == NULL; i++) {
+            hsm = prv_ring_pop(&sched->rings[(worker + i) % sched->workers]);
+        }
+        if (hsm == NULL) {
+            return turns;
+        }
+
+        HSM_ATOMIC_STORE(&hsm->sched_state, PRV_RUNNING);
+        hsm_process_max(hsm, HSM_CFG_SCHED_BUDGET);
+        turns++;
+
+        /*
+         * Back to idle, unless budget ran out or events arrived meanwhile.
+         * Queue is only read while this worker still owns the instance,
+         * a post after the check turns the state to PRV_RUNNING_DIRTY.
+         */
+        idle = 0;
+        state = PRV_RUNNING;
+        if (!hsm_queue_pending(hsm)) {
+            do {
+                idle = HSM_ATOMIC_CAS(&hsm->sched_state, &state, PRV_IDLE);
+            } while (!idle && state == PRV_RUNNING);
+        }
+        if (!idle) {
+            HSM_ATOMIC_STORE(&hsm->sched_state, PRV_QUEUED);
+            prv_enqueue(sched, hsm);
+        }
+    }
+}
+
+#endif /* HSM_CFG_SCHED */
@@ -0,0 +1,117 @@
+/**
+ * \file            hsm_sched.h
+ * \brief           Multi-instance HSM scheduler
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ * Version:         2.0.0
+ */
+#ifndef HSM_SCHED_HDR_H
+#define HSM_SCHED_HDR_H
+
+#include "hsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if HSM_CFG_SCHED
+
+/**
+ * \defgroup        HSM_SCHED Scheduler
+ * \brief           Run many queued HSM instances on a pool of workers
+ *
+ * Instances with posted events are placed on the run queue of their home
+ * worker. Workers take instances from their own run queue first and steal
+ * from other workers when it is empty. An instance is never processed by
+ * two workers at the same time.
+ *
+ * The scheduler does not create threads: the application runs one task per
+ * worker calling \ref hsm_sched_poll and sleeps until the notify function
+ * wakes it.
+ *
+ * \{
+ */
+
+/**
+ * \brief           Run queue slot
+ */
+typedef struct {
+    uint32_t seq;                             /*!< Slot sequence number */
+    hsm_t* hsm;                               /*!< Ready instance */
+} hsm_sched_slot_t;
+
+/**
+ * \brief           Lock-free multi-producer multi-consumer run queue
+ */
+typedef struct {
+    hsm_sched_slot_t* slots;                  /*!< Slot storage */
+    uint32_t mask;                            /*!< Number of slots minus one */
+    uint32_t head;                            /*!< Next position to write */
+    uint32_t tail;                            /*!< Next position to read */
+} hsm_sched_ring_t;
+
+struct hsm_sched;
+
+/**
+ * \brief           Worker wake-up function prototype
+ * \param[in]       sched: Pointer to scheduler
+ * \param[in]       worker: Worker that received work
+ * \param[in]       arg: User argument
+ */
+typedef void (*hsm_sched_notify_fn)(struct hsm_sched* sched, uint8_t worker, void* arg);
+
+/**
+ * \brief           Scheduler structure
+ */
+typedef struct hsm_sched {
+    hsm_sched_ring_t rings[HSM_CFG_SCHED_MAX_WORKERS]; /*!< Run queue per worker */
+    uint8_t workers;                          /*!< Number of workers */
+    uint8_t next_home;                        /*!< Home worker of next attached instance */
+    uint32_t capacity;                        /*!< Total run queue slots */
+    uint32_t attached;                        /*!< Number of attached instances */
+    hsm_sched_notify_fn notify;               /*!< Worker wake-up function */
+    void* notify_arg;                         /*!< User argument of `notify` */
+} hsm_sched_t;
+
+hsm_result_t hsm_sched_init(hsm_sched_t* sched, hsm_sched_slot_t* slots, uint32_t slots_per_worker,
+                            uint8_t workers, hsm_sched_notify_fn notify, void* arg);
+hsm_result_t hsm_sched_attach(hsm_sched_t* sched, hsm_t* hsm);
+uint32_t hsm_sched_poll(hsm_sched_t* sched, uint8_t worker);
+
+/**
+ * \}
+ */
+
+#endif /* HSM_CFG_SCHED */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HSM_SCHED_HDR_H */
@@ -0,0 +1,948 @@
+/**
+ * \file            hsm_table.c
+ * \brief           Compact state table mode implementation
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+#include "hsm_table.h"
+#include <string.h>
+
+#if HSM_CFG_TABLE
+
+/**
+ * \brief           Get depth of state in table
+ * \param[in]       states: State array
+ * \param[in]       state: State index
+ * \return          Depth level, 0 for root
+ */
+static uint8_t
+prv_depth(const hsm_table_state_t* states, uint8_t state) {
+    uint8_t depth = 0;
+
+    while (states[state].parent != HSM_TABLE_NONE) {
+        state = states[state].parent;
+        depth++;
+    }
+    return depth;
+}
+
+/**
+ * \brief           Find lowest common ancestor by walking parents
+ * \param[in]       states: State array
+ * \param[in]       s1: First state index
+ * \param[in]       s2: Second state index
+ * \return          LCA index, \ref HSM_TABLE_NONE if states have different roots
+ */
+static uint8_t
+prv_lca_walk(const hsm_table_state_t* states, uint8_t s1, uint8_t s2) {
+    uint8_t d1 = prv_depth(states, s1), d2 = prv_depth(states, s2);
+
+    for (; d1 > d2; d1--) {
+        s1 = states[s1].parent;
+    }
+    for (; d2 > d1; d2--) {
+        s2 = states[s2].parent;
+    }
+    while (s1 != s2) {
+        s1 = states[s1].parent;
+        s2 = states[s2].parent;
+    }
+    return s1;
+}
+
+/**
+ * \brief           Find lowest common ancestor, precomputed when available
+ * \param[in]       t: Machine definition
+ * \param[in]       s1: First state index
+ * \param[in]       s2: Second state index
+ * \return          LCA index, \ref HSM_TABLE_NONE if states have different roots
+ */
+static inline uint8_t
+prv_lca(const hsm_table_t* t, uint8_t s1, uint8_t s2) {
+    if (t->lca != NULL) {
+        return t->lca[(uint32_t)s1 * t->count + s2];
+    }
+    return prv_lca_walk(t->states, s1, s2);
+}
+
+/**
+ * \brief           Send ENTRY or EXIT to state handler
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       state: State index
+ * \param[in]       event: Event to send
+ * \param[in]       param: Transition parameter
+ */
+static void
+prv_execute(hsm_table_inst_t* inst, uint8_t state, hsm_event_t event, void* param) {
+    const hsm_table_t* t = inst->table;
+
+    inst->active = state;
+    t->handlers[t->states[state].handler](inst, event, param);
+}
+
+/**
+ * \brief           Execute one transition, `in_transition` must be clear
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       target: Target state index
+ * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
+ * \param[in]       method: Optional hook function called between EXIT and ENTRY
+ */
+static void
+prv_transition(hsm_table_inst_t* inst, uint8_t target, void* param,
+               void (*method)(hsm_table_inst_t* inst, void* param)) {
+    const hsm_table_state_t* states = inst->table->states;
+    uint8_t entry_path[HSM_CFG_MAX_DEPTH];
+    uint8_t s1, s2, lca, entry_count;
+
+    /* Find lowest common ancestor */
+    lca = prv_lca(inst->table, inst->current, target);
+
+    /* Build entry path from target up to LCA */
+    entry_count = 0;
+    for (s2 = target; s2 != lca; s2 = states[s2].parent) {
+        entry_path[entry_count++] = s2;
+    }
+
+    inst->in_transition = 1;
+
+    /* Execute exit actions from current up to LCA */
+    for (s1 = inst->current; s1 != lca; s1 = states[s1].parent) {
+        prv_execute(inst, s1, HSM_EVENT_EXIT, param);
+    }
+
+    if (method != NULL) {
+        method(inst, param);
+    }
+
+    /* Execute entry actions from LCA down to target */
+    while (entry_count > 0) {
+        prv_execute(inst, entry_path[--entry_count], HSM_EVENT_ENTRY, param);
+    }
+
+    inst->current = target;
+    inst->in_transition = 0;
+}
+
+/**
+ * \brief           Execute deferred transitions in request order
+ * \param[in]       inst: Pointer to table instance
+ */
+static void
+prv_run_deferred(hsm_table_inst_t* inst) {
+    hsm_table_deferred_t d;
+
+    while (inst->deferred_count > 0) {
+        d = inst->deferred[inst->deferred_head];
+        inst->deferred_head = (uint8_t)((inst->deferred_head + 1) % HSM_CFG_DEFER_SIZE);
+        inst->deferred_count--;
+        prv_transition(inst, d.target, d.param, d.method);
+    }
+}
+
+/**
+ * \brief           Validate machine definition
+ *
+ * Checks all parent and handler indices, parent cycles, nesting depth
+ * and the optional LCA table.
+ * Call once per definition, instances do not repeat these checks.
+ *
+ * \param[in]       table: Machine definition
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_MAX_DEPTH if nested
+ *                  deeper than `HSM_CFG_MAX_DEPTH` or cyclic
+ */
+hsm_result_t
+hsm_table_check(const hsm_table_t* table) {
+    uint8_t i, s, levels;
+
+    if (table == NULL || table->states == NULL || table->handlers == NULL || table->count == 0
+        || table->count == HSM_TABLE_NONE) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (i = 0; i < table->count; i++) {
+        const hsm_table_state_t* st = &table->states[i];
+
+        if (st->handler >= table->handler_count || table->handlers[st->handler] == NULL
+            || (st->parent != HSM_TABLE_NONE && st->parent >= table->count)) {
+            return HSM_RES_INVALID_PARAM;
+        }
+
+        /* Parent chain must reach a root within maximum depth */
+        levels = 1;
+        for (s = st->parent; s != HSM_TABLE_NONE; s = table->states[s].parent) {
+            if (++levels > HSM_CFG_MAX_DEPTH) {
+                return HSM_RES_MAX_DEPTH;
+            }
+        }
+    }
+
+    /* Precomputed LCA table must match the hierarchy */
+    if (table->lca != NULL) {
+        for (i = 0; i < table->count; i++) {
+            for (s = 0; s < table->count; s++) {
+                if (table->lca[(uint32_t)i * table->count + s] != prv_lca_walk(table->states, i, s)) {
+                    return HSM_RES_INVALID_PARAM;
+                }
+            }
+        }
+    }
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Initialize table instance and enter initial state
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       table: Machine definition, checked with \ref hsm_table_check
+ * \param[in]       initial: Initial state index
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_table_init(hsm_table_inst_t* inst, const hsm_table_t* table, uint8_t initial) {
+    if (inst == NULL || table == NULL || initial >= table->count) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    inst->table = table;
+    inst->current = initial;
+    inst->active = initial;
+    inst->deferred_head = 0;
+    inst->deferred_count = 0;
+
+    inst->in_transition = 1;
+    prv_execute(inst, initial, HSM_EVENT_ENTRY, NULL);
+    inst->in_transition = 0;
+
+    /* Run transitions requested in ENTRY */
+    prv_run_deferred(inst);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Dispatch event to current state
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_UNHANDLED when no state
+ *                  consumed the event (with \ref HSM_CFG_UNHANDLED)
+ */
+hsm_result_t
+hsm_table_dispatch(hsm_table_inst_t* inst, hsm_event_t event, void* data) {
+    const hsm_table_state_t* states;
+    const hsm_table_fn_t* handlers;
+    uint8_t s;
+
+    if (inst == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    states = inst->table->states;
+    handlers = inst->table->handlers;
+
+    /* Propagate event up the state hierarchy */
+    for (s = inst->current; s != HSM_TABLE_NONE && event != HSM_EVENT_NONE; s = states[s].parent) {
+        inst->active = s;
+        event = handlers[states[s].handler](inst, event, data);
+    }
+
+#if HSM_CFG_UNHANDLED
+    return event == HSM_EVENT_NONE ? HSM_RES_OK : HSM_RES_UNHANDLED;
+#else
+    return HSM_RES_OK;
+#endif /* HSM_CFG_UNHANDLED */
+}
+
+/**
+ * \brief           Transition to target state
+ *
+ * When called from an ENTRY or EXIT handler, the transition is queued and
+ * executed after the running transition completes.
+ *
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       target: Target state index
+ * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
+ * \param[in]       method: Optional hook function called between EXIT and ENTRY
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_FULL if deferred
+ *                  transition queue is full
+ */
+hsm_result_t
+hsm_table_transition(hsm_table_inst_t* inst, uint8_t target, void* param,
+                     void (*method)(hsm_table_inst_t* inst, void* param)) {
+    hsm_table_deferred_t* d;
+
+    if (inst == NULL || target >= inst->table->count) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    /* If already in transition, defer this transition */
+    if (inst->in_transition) {
+        if (inst->deferred_count >= HSM_CFG_DEFER_SIZE) {
+            return HSM_RES_FULL;
+        }
+        d = &inst->deferred[(inst->deferred_head + inst->deferred_count) % HSM_CFG_DEFER_SIZE];
+        d->target = target;
+        d->param = param;
+        d->method = method;
+        inst->deferred_count++;
+        return HSM_RES_OK;
+    }
+
+    prv_transition(inst, target, param, method);
+    prv_run_deferred(inst);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Get current state index
+ * \param[in]       inst: Pointer to table instance
+ * \return          Current state index, \ref HSM_TABLE_NONE if `inst` is `NULL`
+ */
+uint8_t
+hsm_table_get_state(const hsm_table_inst_t* inst) {
+    return (inst != NULL) ? inst->current : HSM_TABLE_NONE;
+}
+
+/**
+ * \brief           Check if in specific state
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       state: State index to check
+ * \return          1 if in state or parent, 0 otherwise
+ */
+uint8_t
+hsm_table_is_in_state(const hsm_table_inst_t* inst, uint8_t state) {
+    uint8_t s;
+
+    if (inst == NULL || state == HSM_TABLE_NONE) {
+        return 0;
+    }
+    for (s = inst->current; s != HSM_TABLE_NONE; s = inst->table->states[s].parent) {
+        if (s == state) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Get state name for debugging
+ * \param[in]       table: Machine definition
+ * \param[in]       state: State index
+ * \return          State name, `NULL` if table has no names or index is invalid
+ */
+const char*
+hsm_table_state_name(const hsm_table_t* table, uint8_t state) {
+    if (table == NULL || table->names == NULL || state >= table->count) {
+        return NULL;
+    }
+    return table->names[state];
+}
+
+#if HSM_CFG_TABLE_BLOB
+
+/**
+ * \brief           Read little-endian 32-bit value
+ * \param[in]       p: Pointer to first byte
+ * \return          Value
+ */
+static uint32_t
+prv_get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * \brief           Write little-endian 32-bit value
+ * \param[out]      p: Pointer to first byte
+ * \param[in]       v: Value
+ */
+static void
+prv_put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * \brief           FNV-1a hash of blob body
+ * \param[in]       data: Bytes to hash
+ * \param[in]       len: Number of bytes
+ * \return          Hash value
+ */
+static uint32_t
+prv_fnv1a(const uint8_t* data, size_t len) {
+    uint32_t h = 0x811C9DC5UL;
+
+    while (len-- > 0) {
+        h = (h ^ *data++) * 0x01000193UL;
+    }
+    return h;
+}
+
+/**
+ * \brief           Bind machine definition blob
+ *
+ * The table points into the blob, nothing is copied: the blob can live
+ * in flash or in a memory mapped file and must stay valid while the
+ * table is in use. Handler index `i` in the blob calls `handlers[i]`.
+ *
+ * Only the header, size, hash and the handler and parent indices are
+ * checked, in one pass over the states. Nesting depth, parent cycles and
+ * the LCA table are left to \ref hsm_table_check or to the host analyser
+ * `tools/hsm_analyse.c`, run once on the blob before it is shipped.
+ *
+ * \param[out]      table: Machine definition to fill
+ * \param[in]       blob: Blob in \ref HSM_TABLE_BLOB_MAGIC format, any alignment
+ * \param[in]       len: Blob size in bytes
+ * \param[in]       handlers: Handler array
+ * \param[in]       handler_count: Number of entries in `handlers`
+ * \return          \ref HSM_RES_OK on success, \ref HSM_RES_INVALID_PARAM if the
+ *                  blob is malformed, corrupted or needs more handlers
+ */
+hsm_result_t
+hsm_table_load(hsm_table_t* table, const void* blob, size_t len, const hsm_table_fn_t* handlers,
+               uint8_t handler_count) {
+    const uint8_t* b = blob;
+    uint8_t count;
+
+    if (table == NULL || b == NULL || handlers == NULL || len < HSM_TABLE_BLOB_HDR_SIZE
+        || memcmp(b, HSM_TABLE_BLOB_MAGIC, 4) != 0 || b[4] != HSM_TABLE_BLOB_VERSION) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    count = b[6];
+    if (count == 0 || count == HSM_TABLE_NONE || b[7] > handler_count || prv_get_u32(&b[8]) != len
+        || len != HSM_TABLE_BLOB_SIZE(count, b[5] & HSM_TABLE_BLOB_FLAG_LCA)
+        || prv_get_u32(&b[12]) != prv_fnv1a(&b[HSM_TABLE_BLOB_HDR_SIZE], len - HSM_TABLE_BLOB_HDR_SIZE)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    /* Indices only, the hash already covers integrity */
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t parent = b[HSM_TABLE_BLOB_HDR_SIZE + 2 * i], handler = b[HSM_TABLE_BLOB_HDR_SIZE + 2 * i + 1];
+
+        if (handler >= handler_count || handlers[handler] == NULL
+            || (parent != HSM_TABLE_NONE && parent >= count)) {
+            return HSM_RES_INVALID_PARAM;
+        }
+    }
+
+    table->states = (const hsm_table_state_t*)&b[HSM_TABLE_BLOB_HDR_SIZE];
+    table->handlers = handlers;
+    table->names = NULL;
+    table->count = count;
+    table->handler_count = handler_count;
+    table->lca = (b[5] & HSM_TABLE_BLOB_FLAG_LCA) ? &b[HSM_TABLE_BLOB_HDR_SIZE + 2 * (size_t)count] : NULL;
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Complete blob whose state array is already written
+ * \param[out]      b: Blob, state array at \ref HSM_TABLE_BLOB_HDR_SIZE
+ * \param[in]       count: Number of states
+ * \param[in]       handlers: Number of handlers referenced
+ * \param[in]       with_lca: Set to `1` to append the LCA table
+ * \param[in]       len: Blob size in bytes
+ */
+static void
+prv_blob_finish(uint8_t* b, uint8_t count, uint8_t handlers, uint8_t with_lca, size_t len) {
+    const hsm_table_state_t* states = (const hsm_table_state_t*)&b[HSM_TABLE_BLOB_HDR_SIZE];
+    size_t pos = HSM_TABLE_BLOB_HDR_SIZE + 2 * (size_t)count;
+    uint8_t i, j;
+
+    memcpy(b, HSM_TABLE_BLOB_MAGIC, 4);
+    b[4] = HSM_TABLE_BLOB_VERSION;
+    b[5] = with_lca ? HSM_TABLE_BLOB_FLAG_LCA : 0;
+    b[6] = count;
+    b[7] = handlers;
+    prv_put_u32(&b[8], (uint32_t)len);
+
+    if (with_lca) {
+        for (i = 0; i < count; i++) {
+            for (j = 0; j < count; j++) {
+                b[pos++] = prv_lca_walk(states, i, j);
+            }
+        }
+    }
+    prv_put_u32(&b[12], prv_fnv1a(&b[HSM_TABLE_BLOB_HDR_SIZE], len - HSM_TABLE_BLOB_HDR_SIZE));
+}
+
+/**
+ * \brief           Write machine definition blob
+ *
+ * Used by model generators and host tools to produce blobs for
+ * \ref hsm_table_load. Handler functions are not stored, only indices.
+ *
+ * \param[in]       table: Machine definition, checked with \ref hsm_table_check
+ * \param[in]       with_lca: Set to `1` to include a precomputed LCA table
+ * \param[out]      buf: Output buffer, can be `NULL` to query the size
+ * \param[in]       size: Output buffer size
+ * \return          Blob size in bytes, `0` if `buf` is too small
+ */
+size_t
+hsm_table_save(const hsm_table_t* table, uint8_t with_lca, void* buf, size_t size) {
+    uint8_t* b = buf;
+    size_t len, pos;
+    uint8_t i;
+
+    if (table == NULL || table->states == NULL) {
+        return 0;
+    }
+
+    len = HSM_TABLE_BLOB_SIZE(table->count, with_lca);
+    if (b == NULL) {
+        return len;
+    }
+    if (size < len) {
+        return 0;
+    }
+
+    pos = HSM_TABLE_BLOB_HDR_SIZE;
+    for (i = 0; i < table->count; i++) {
+        b[pos++] = table->states[i].parent;
+        b[pos++] = table->states[i].handler;
+    }
+    prv_blob_finish(b, table->count, table->handler_count, with_lca, len);
+
+    return len;
+}
+
+/**
+ * \brief           Write definition blob of a pointer mode machine
+ *
+ * Lets `tools/hsm_analyse.c` check machines built with \ref hsm_state_create.
+ * Blob state `i` is `states[i]`, states sharing a handler function share
+ * a handler index. The blob is meant for analysis, its handler indices
+ * do not refer to any \ref hsm_table_fn_t array.
+ *
+ * \param[in]       states: Every state of the machine, up to `254` entries
+ * \param[in]       count: Number of states
+ * \param[in]       with_lca: Set to `1` to include a precomputed LCA table
+ * \param[out]      buf: Output buffer, can be `NULL` to query the size
+ * \param[in]       size: Output buffer size
+ * \return          Blob size in bytes, `0` if `buf` is too small, a parent is
+ *                  not part of `states` or parents form a cycle
+ */
+size_t
+hsm_table_save_states(hsm_state_t* const* states, uint8_t count, uint8_t with_lca, void* buf, size_t size) {
+    uint8_t* b = buf;
+    hsm_table_state_t* t;
+    size_t len;
+    uint8_t i, j, handlers = 0;
+
+    if (states == NULL || count == 0 || count == HSM_TABLE_NONE) {
+        return 0;
+    }
+
+    len = HSM_TABLE_BLOB_SIZE(count, with_lca);
+    if (b == NULL) {
+        return len;
+    }
+    if (size < len) {
+        return 0;
+    }
+
+    t = (hsm_table_state_t*)&b[HSM_TABLE_BLOB_HDR_SIZE];
+    for (i = 0; i < count; i++) {
+        if (states[i] == NULL) {
+            return 0;
+        }
+        t[i].parent = HSM_TABLE_NONE;
+        for (j = 0; j < count && states[i]->parent != NULL; j++) {
+            if (states[j] == states[i]->parent) {
+                t[i].parent = j;
+                break;
+            }
+        }
+        if (states[i]->parent != NULL && t[i].parent == HSM_TABLE_NONE) {
+            return 0;
+        }
+        for (j = 0; j < i && states[j]->handler != states[i]->handler; j++) {}
+        t[i].handler = (j < i) ? t[j].handler : handlers++;
+    }
+
+    /* A chain longer than the set is a cycle, LCA walks would not end */
+    for (i = 0; i < count; i++) {
+        uint8_t s = t[i].parent;
+
+        for (j = 0; j < count && s != HSM_TABLE_NONE; j++) {
+            s = t[s].parent;
+        }
+        if (s != HSM_TABLE_NONE) {
+            return 0;
+        }
+    }
+    prv_blob_finish(b, count, handlers, with_lca, len);
+
+    return len;
+}
+
+#endif /* HSM_CFG_TABLE_BLOB */
+
+#if HSM_CFG_TABLE_POOL
+
+/**
+ * \brief           Working instance of a pool member
+ *
+ * `inst` must stay the first member, \ref hsm_table_pool_index converts
+ * the handler argument back.
+ */
+typedef struct {
+    hsm_table_inst_t inst;                    /*!< Instance passed to handlers */
+    uint32_t index;                           /*!< Pool index of the instance */
+} prv_pool_inst_t;
+
+/**
+ * \brief           Load pool member into working instance
+ *
+ * Transitions complete before pool functions return, so the deferred
+ * queue is always empty between events and only the state is loaded.
+ *
+ * \param[in]       w: Working instance with `table` and empty deferred queue
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       index: Instance index
+ */
+static void
+prv_pool_load(prv_pool_inst_t* w, const hsm_table_pool_t* pool, uint32_t index) {
+    w->index = index;
+    w->inst.current = pool->current[index];
+    w->inst.active = w->inst.current;
+}
+
+/**
+ * \brief           Prepare working instance for pool
+ * \param[out]      w: Working instance
+ * \param[in]       pool: Pointer to pool
+ */
+static void
+prv_pool_setup(prv_pool_inst_t* w, const hsm_table_pool_t* pool) {
+    w->inst.table = pool->table;
+    w->inst.in_transition = 0;
+    w->inst.deferred_head = 0;
+    w->inst.deferred_count = 0;
+}
+
+/**
+ * \brief           Find declarative transition of state for event
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       state: Current state index
+ * \param[in]       event: Event
+ * \param[out]      flags: Flags of the matching rule
+ * \return          Target state index, \ref HSM_TABLE_NONE when handlers decide
+ */
+static uint8_t
+prv_pool_rule(const hsm_table_pool_t* pool, uint8_t state, hsm_event_t event, uint8_t* flags) {
+    const hsm_table_state_t* states = pool->table->states;
+
+    for (uint8_t s = state; s != HSM_TABLE_NONE; s = states[s].parent) {
+        for (uint8_t r = 0; r < pool->rule_count; r++) {
+            if (pool->rules[r].state == s && pool->rules[r].event == event) {
+                *flags = pool->rules[r].flags;
+                return pool->rules[r].target;
+            }
+        }
+    }
+    *flags = 0;
+    return HSM_TABLE_NONE;
+}
+
+/**
+ * \brief           Deliver event to loaded pool member
+ * \param[in]       w: Working instance, loaded with \ref prv_pool_load
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
+ */
+static void
+prv_pool_event(prv_pool_inst_t* w, hsm_table_pool_t* pool, hsm_event_t event, void* data) {
+    uint8_t flags, target;
+
+    target = prv_pool_rule(pool, w->inst.current, event, &flags);
+    if (target == HSM_TABLE_NONE) {
+        hsm_table_dispatch(&w->inst, event, data);
+    } else if (flags & HSM_TABLE_RULE_QUIET) {
+        w->inst.current = target;
+    } else {
+        hsm_table_transition(&w->inst, target, data, NULL);
+    }
+    pool->current[w->index] = w->inst.current;
+}
+
+/**
+ * \brief           Initialize instance pool and enter initial state of every instance
+ * \param[out]      pool: Pointer to pool
+ * \param[in]       table: Machine definition, checked with \ref hsm_table_check
+ * \param[in]       current: Storage for `count` state indices, aligned to
+ *                      \ref HSM_CFG_TABLE_POOL_ALIGN for best sharding
+ * \param[in]       count: Number of instances
+ * \param[in]       initial: Initial state index
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_table_pool_init(hsm_table_pool_t* pool, const hsm_table_t* table, uint8_t* current, uint32_t count,
+                    uint8_t initial) {
+    prv_pool_inst_t w;
+
+    if (pool == NULL || table == NULL || current == NULL || count == 0 || initial >= table->count) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    pool->table = table;
+    pool->current = current;
+    pool->count = count;
+    pool->rules = NULL;
+    pool->rule_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        w.index = i;
+        hsm_table_init(&w.inst, table, initial);
+        current[i] = w.inst.current;
+    }
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Set declarative transitions of pool
+ *
+ * Events with a matching rule do not reach handlers, so broadcasts
+ * resolve them once per state instead of once per instance.
+ *
+ * \param[in]       pool: Pointer to initialized pool
+ * \param[in]       rules: Rule array, must stay valid, `NULL` to remove
+ * \param[in]       count: Number of rules
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_table_pool_set_rules(hsm_table_pool_t* pool, const hsm_table_rule_t* rules, uint8_t count) {
+    if (pool == NULL || (rules == NULL && count > 0)) {
+        return HSM_RES_INVALID_PARAM;
+    }
+    for (uint8_t r = 0; r < count; r++) {
+        if (rules[r].state >= pool->table->count || rules[r].target >= pool->table->count
+            || rules[r].event < HSM_EVENT_USER) {
+            return HSM_RES_INVALID_PARAM;
+        }
+    }
+
+    pool->rules = rules;
+    pool->rule_count = (rules != NULL) ? count : 0;
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Dispatch event to one pool instance
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       index: Instance index
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_table_pool_dispatch(hsm_table_pool_t* pool, uint32_t index, hsm_event_t event, void* data) {
+    prv_pool_inst_t w;
+
+    if (pool == NULL || index >= pool->count) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    prv_pool_setup(&w, pool);
+    prv_pool_load(&w, pool, index);
+    prv_pool_event(&w, pool, event, data);
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Dispatch event to a range of pool instances
+ *
+ * One linear pass over the state array, the working instance is set up
+ * once for the whole range. When rules exist for `event` and the range
+ * is at least as large as the machine, the rule of every state is
+ * resolved once up front; instances whose rule is \ref HSM_TABLE_RULE_QUIET
+ * are then only relabelled, without calling any handler.
+ *
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       first: First instance index
+ * \param[in]       count: Number of instances, clamped to the pool size
+ * \param[in]       event: Event to dispatch
+ * \param[in]       data: Event data, shared by all instances
+ * \return          Number of instances dispatched
+ */
+uint32_t
+hsm_table_pool_broadcast(hsm_table_pool_t* pool, uint32_t first, uint32_t count, hsm_event_t event,
+                         void* data) {
+    prv_pool_inst_t w;
+    uint32_t end;
+
+    if (pool == NULL || first >= pool->count) {
+        return 0;
+    }
+    if (count > pool->count - first) {
+        count = pool->count - first;
+    }
+
+    prv_pool_setup(&w, pool);
+    end = first + count;
+    if (pool->rule_count > 0 && count >= pool->table->count) {
+        uint8_t map[HSM_TABLE_NONE], quiet[(HSM_TABLE_NONE + 7) / 8];
+        uint8_t flags, s, all_quiet = 1;
+
+        /* Resolve once per state, O(states + instances) instead of O(instances * depth) */
+        for (s = 0; s < pool->table->count; s++) {
+            map[s] = prv_pool_rule(pool, s, event, &flags);
+            if (map[s] != HSM_TABLE_NONE && (flags & HSM_TABLE_RULE_QUIET)) {
+                quiet[s >> 3] |= (uint8_t)(1U << (s & 7));
+            } else {
+                quiet[s >> 3] &= (uint8_t)~(1U << (s & 7));
+                all_quiet = 0;
+            }
+        }
+
+        if (all_quiet) {
+            /* Pure relabel of the state array */
+            for (uint8_t* cur = &pool->current[first]; first < end; first++, cur++) {
+                *cur = map[*cur];
+            }
+            return count;
+        }
+        for (; first < end; first++) {
+            s = pool->current[first];
+            if (quiet[s >> 3] & (1U << (s & 7))) {
+                pool->current[first] = map[s];
+                continue;
+            }
+            prv_pool_load(&w, pool, first);
+            if (map[s] == HSM_TABLE_NONE) {
+                hsm_table_dispatch(&w.inst, event, data);
+            } else {
+                hsm_table_transition(&w.inst, map[s], data, NULL);
+            }
+            pool->current[first] = w.inst.current;
+        }
+        return count;
+    }
+
+    for (; first < end; first++) {
+        prv_pool_load(&w, pool, first);
+        prv_pool_event(&w, pool, event, data);
+    }
+    return count;
+}
+
+/**
+ * \brief           Transition one pool instance to target state
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       index: Instance index
+ * \param[in]       target: Target state index
+ * \param[in]       param: Optional parameter passed to ENTRY and EXIT events
+ * \param[in]       method: Optional hook function called between EXIT and ENTRY
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_table_pool_transition(hsm_table_pool_t* pool, uint32_t index, uint8_t target, void* param,
+                          void (*method)(hsm_table_inst_t* inst, void* param)) {
+    prv_pool_inst_t w;
+    hsm_result_t res;
+
+    if (pool == NULL || index >= pool->count) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    prv_pool_setup(&w, pool);
+    prv_pool_load(&w, pool, index);
+    res = hsm_table_transition(&w.inst, target, param, method);
+    pool->current[index] = w.inst.current;
+    return res;
+}
+
+/**
+ * \brief           Get instance range of one worker shard
+ *
+ * Splits the pool into `shards` contiguous ranges whose boundaries fall on
+ * \ref HSM_CFG_TABLE_POOL_ALIGN byte boundaries of the state array, so
+ * workers dispatching different shards never write the same cache line.
+ * Trailing shards may be empty for small pools.
+ *
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       shard: Shard number, `0` to `shards - 1`
+ * \param[in]       shards: Number of shards
+ * \param[out]      first: First instance index of the shard
+ * \return          Number of instances in the shard
+ */
+uint32_t
+hsm_table_pool_shard(const hsm_table_pool_t* pool, uint8_t shard, uint8_t shards, uint32_t* first) {
+    uint32_t lead, step, begin, end;
+
+    if (pool == NULL || first == NULL || shard >= shards) {
+        return 0;
+    }
+
+    /* Instances before the first aligned line belong to shard 0 */
+    lead = (uint32_t)(-(uintptr_t)pool->current & (HSM_CFG_TABLE_POOL_ALIGN - 1));
+    if (lead > pool->count) {
+        lead = pool->count;
+    }
+    step = (pool->count - lead + shards - 1) / shards;
+    step = (step + HSM_CFG_TABLE_POOL_ALIGN - 1) & ~(uint32_t)(HSM_CFG_TABLE_POOL_ALIGN - 1);
+
+    begin = (shard == 0) ? 0 : lead + shard * step;
+    end = (shard + 1 == shards) ? pool->count : lead + (shard + 1) * step;
+    if (begin > pool->count) {
+        begin = pool->count;
+    }
+    if (end > pool->count) {
+        end = pool->count;
+    }
+    *first = begin;
+    return end - begin;
+}
+
+/**
+ * \brief           Get current state index of pool instance
+ * \param[in]       pool: Pointer to pool
+ * \param[in]       index: Instance index
+ * \return          Current state index, \ref HSM_TABLE_NONE if parameters are invalid
+ */
+uint8_t
+hsm_table_pool_get_state(const hsm_table_pool_t* pool, uint32_t index) {
+    return (pool != NULL && index < pool->count) ? pool->current[index] : HSM_TABLE_NONE;
+}
+
+/**
+ * \brief           Get pool index of the instance a handler runs for
+ * \note            Only valid for instances passed to handlers by pool functions
+ * \param[in]       inst: Instance received by the handler
+ * \return          Instance index in its pool
+ */
+uint32_t
+hsm_table_pool_index(const hsm_table_inst_t* inst) {
+    return ((const prv_pool_inst_t*)inst)->index;
+}
+
+#endif /* HSM_CFG_TABLE_POOL */
+
+#endif /* HSM_CFG_TABLE */
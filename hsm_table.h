@@ -0,0 +1,232 @@
+/**
+ * \file            hsm_table.h
+ * \brief           Compact state table mode
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ * Version:         2.0.0
+ */
+#ifndef HSM_TABLE_HDR_H
+#define HSM_TABLE_HDR_H
+
+#include "hsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if HSM_CFG_TABLE
+
+/**
+ * \defgroup        HSM_TABLE Compact state table
+ * \brief           Machines defined by a contiguous constant array of states
+ *
+ * States live in one `const` array, placeable in flash, with `uint8_t`
+ * parent and handler indices. The instance tracks its current state as
+ * an index, so hierarchy walks stay within a few cache lines and states
+ * take no RAM at all.
+ *
+ * \{
+ */
+
+#define HSM_TABLE_NONE 0xFF                   /*!< No state, parent index of root states */
+
+#if HSM_CFG_TABLE_BLOB
+/**
+ * \brief           Machine definition blob format
+ *
+ * All fields are bytes or little-endian words with no alignment
+ * requirement, so the blob is used in place by \ref hsm_table_load.
+ *
+ * | Offset         | Size        | Content                                       |
+ * |----------------|-------------|-----------------------------------------------|
+ * | 0              | 4           | Magic `"HSMD"`                                |
+ * | 4              | 1           | Version, \ref HSM_TABLE_BLOB_VERSION          |
+ * | 5              | 1           | Flags, \ref HSM_TABLE_BLOB_FLAG_LCA           |
+ * | 6              | 1           | State count `n`                               |
+ * | 7              | 1           | Number of handlers referenced                 |
+ * | 8              | 4           | Total blob size                               |
+ * | 12             | 4           | FNV-1a hash of bytes from offset 16           |
+ * | 16             | 2 * n       | \ref hsm_table_state_t array                  |
+ * | 16 + 2 * n     | n * n       | LCA table, if flag set                        |
+ */
+#define HSM_TABLE_BLOB_MAGIC      "HSMD"
+#define HSM_TABLE_BLOB_VERSION    1
+#define HSM_TABLE_BLOB_HDR_SIZE   16
+#define HSM_TABLE_BLOB_FLAG_LCA   0x01        /*!< Blob contains precomputed LCA table */
+
+/**
+ * \brief           Blob size for `count` states
+ * \param[in]       count: Number of states
+ * \param[in]       lca: Non-zero if LCA table is included
+ */
+#define HSM_TABLE_BLOB_SIZE(count, lca)                                                            \
+    ((size_t)HSM_TABLE_BLOB_HDR_SIZE + 2 * (size_t)(count) + ((lca) ? (size_t)(count) * (count) : 0))
+#endif /* HSM_CFG_TABLE_BLOB */
+
+struct hsm_table_inst;
+
+/**
+ * \brief           Table mode state handler function prototype
+ * \param[in]       inst: Pointer to table instance
+ * \param[in]       event: Event to handle
+ * \param[in]       data: Event data pointer
+ * \return          Event to propagate to parent, or `HSM_EVENT_NONE` if handled
+ */
+typedef hsm_event_t (*hsm_table_fn_t)(struct hsm_table_inst* inst, hsm_event_t event, void* data);
+
+/**
+ * \brief           Table mode state entry
+ */
+typedef struct {
+    uint8_t parent;                           /*!< Parent state index or \ref HSM_TABLE_NONE */
+    uint8_t handler;                          /*!< Index in handler array */
+} hsm_table_state_t;
+
+/**
+ * \brief           Initializer for \ref hsm_table_state_t
+ * \param[in]       parent: Parent state index or \ref HSM_TABLE_NONE
+ * \param[in]       handler: Handler index
+ */
+#define HSM_TABLE_STATE(parent, handler)      {(parent), (handler)}
+
+/**
+ * \brief           Table mode machine definition
+ */
+typedef struct {
+    const hsm_table_state_t* states;          /*!< State array, index is state id */
+    const hsm_table_fn_t* handlers;           /*!< Handler array */
+    const char* const* names;                 /*!< Optional state names, can be `NULL` */
+    uint8_t count;                            /*!< Number of states, up to `254` */
+    uint8_t handler_count;                    /*!< Number of handlers */
+    const uint8_t* lca;                       /*!< Optional `count * count` LCA table, `[from * count + to]`,
+                                                   can be `NULL` */
+} hsm_table_t;
+
+/**
+ * \brief           Table mode transition requested while another transition is running
+ */
+typedef struct {
+    void* param;                              /*!< Parameter passed to ENTRY and EXIT events */
+    void (*method)(struct hsm_table_inst* inst, void* param); /*!< Optional hook called between EXIT and ENTRY */
+    uint8_t target;                           /*!< Target state index */
+} hsm_table_deferred_t;
+
+/**
+ * \brief           Table mode instance
+ */
+typedef struct hsm_table_inst {
+    const hsm_table_t* table;                 /*!< Machine definition */
+    uint8_t current;                          /*!< Current state index */
+    uint8_t active;                           /*!< State whose handler is running, for shared handlers */
+    uint8_t in_transition;                    /*!< Transition in progress flag */
+    uint8_t deferred_head;                    /*!< First pending deferred transition */
+    uint8_t deferred_count;                   /*!< Number of pending deferred transitions */
+    hsm_table_deferred_t deferred[HSM_CFG_DEFER_SIZE]; /*!< Deferred transition queue */
+} hsm_table_inst_t;
+
+/* Definition */
+hsm_result_t hsm_table_check(const hsm_table_t* table);
+
+/* Instance */
+hsm_result_t hsm_table_init(hsm_table_inst_t* inst, const hsm_table_t* table, uint8_t initial);
+hsm_result_t hsm_table_dispatch(hsm_table_inst_t* inst, hsm_event_t event, void* data);
+hsm_result_t hsm_table_transition(hsm_table_inst_t* inst, uint8_t target, void* param,
+                                  void (*method)(hsm_table_inst_t* inst, void* param));
+uint8_t hsm_table_get_state(const hsm_table_inst_t* inst);
+uint8_t hsm_table_is_in_state(const hsm_table_inst_t* inst, uint8_t state);
+const char* hsm_table_state_name(const hsm_table_t* table, uint8_t state);
+
+#if HSM_CFG_TABLE_BLOB
+/* Serialised definitions */
+hsm_result_t hsm_table_load(hsm_table_t* table, const void* blob, size_t len, const hsm_table_fn_t* handlers,
+                            uint8_t handler_count);
+size_t hsm_table_save(const hsm_table_t* table, uint8_t with_lca, void* buf, size_t size);
+size_t hsm_table_save_states(hsm_state_t* const* states, uint8_t count, uint8_t with_lca, void* buf,
+                             size_t size);
+#endif /* HSM_CFG_TABLE_BLOB */
+
+#if HSM_CFG_TABLE_POOL
+#define HSM_TABLE_RULE_QUIET 0x01             /*!< Rule changes state without ENTRY and EXIT handlers */
+
+/**
+ * \brief           Declarative pool transition
+ *
+ * Applies to `state` and its substates, the rule of the innermost state
+ * wins. Rules are checked before handlers: an event with a matching rule
+ * does not reach the handlers, event data is the transition parameter.
+ */
+typedef struct {
+    hsm_event_t event;                        /*!< Triggering event */
+    uint8_t state;                            /*!< Source state index */
+    uint8_t target;                           /*!< Target state index */
+    uint8_t flags;                            /*!< \ref HSM_TABLE_RULE_QUIET or `0` */
+} hsm_table_rule_t;
+
+/**
+ * \brief           Population of table mode instances sharing one definition
+ *
+ * Between events an instance only needs its current state, so the pool
+ * keeps one byte per instance in a dense array. Handlers run on a
+ * temporary \ref hsm_table_inst_t and find their instance with
+ * \ref hsm_table_pool_index, per-instance application data lives in
+ * separate arrays indexed the same way.
+ */
+typedef struct {
+    const hsm_table_t* table;                 /*!< Machine definition */
+    uint8_t* current;                         /*!< Current state index per instance */
+    uint32_t count;                           /*!< Number of instances */
+    const hsm_table_rule_t* rules;            /*!< Declarative transitions or `NULL` */
+    uint8_t rule_count;                       /*!< Number of rules */
+} hsm_table_pool_t;
+
+/* Instance pool */
+hsm_result_t hsm_table_pool_init(hsm_table_pool_t* pool, const hsm_table_t* table, uint8_t* current,
+                                 uint32_t count, uint8_t initial);
+hsm_result_t hsm_table_pool_set_rules(hsm_table_pool_t* pool, const hsm_table_rule_t* rules, uint8_t count);
+hsm_result_t hsm_table_pool_dispatch(hsm_table_pool_t* pool, uint32_t index, hsm_event_t event, void* data);
+uint32_t hsm_table_pool_broadcast(hsm_table_pool_t* pool, uint32_t first, uint32_t count, hsm_event_t event,
+                                  void* data);
+hsm_result_t hsm_table_pool_transition(hsm_table_pool_t* pool, uint32_t index, uint8_t target, void* param,
+                                       void (*method)(hsm_table_inst_t* inst, void* param));
+uint32_t hsm_table_pool_shard(const hsm_table_pool_t* pool, uint8_t shard, uint8_t shards, uint32_t* first);
+uint8_t hsm_table_pool_get_state(const hsm_table_pool_t* pool, uint32_t index);
+uint32_t hsm_table_pool_index(const hsm_table_inst_t* inst);
+#endif /* HSM_CFG_TABLE_POOL */
+
+/**
+ * \}
+ */
+
+#endif /* HSM_CFG_TABLE */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HSM_TABLE_HDR_H */
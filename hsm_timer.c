@@ -0,0 +1,310 @@
+/**
+ * \file            hsm_timer.c
+ * \brief           Hierarchical timer wheel for HSM time events
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+#include "hsm_timer.h"
+
+#if HSM_CFG_TIMER
+
+#if !HSM_CFG_QUEUE
+#error "HSM_CFG_TIMER requires HSM_CFG_QUEUE"
+#endif
+
+/* Serialisation of wheel access, defined by the build system when needed */
+#ifndef HSM_CFG_TIMER_LOCK
+#define HSM_CFG_TIMER_LOCK()
+#endif
+#ifndef HSM_CFG_TIMER_UNLOCK
+#define HSM_CFG_TIMER_UNLOCK()
+#endif
+
+#define PRV_MASK                 (HSM_TIMER_SLOTS - 1)
+
+/* Longest distance the wheel can place exactly, longer timers are re-placed on cascade */
+#if HSM_CFG_TIMER_BITS * HSM_CFG_TIMER_LEVELS >= 32
+#define PRV_RANGE                0x7FFFFFFFUL
+#else
+#define PRV_RANGE                ((1UL << (HSM_CFG_TIMER_BITS * HSM_CFG_TIMER_LEVELS)) - 1)
+#endif
+
+/* Longest accepted delay, keeps expiry comparisons unambiguous */
+#define PRV_MAX_TICKS            0x7FFFFFFFUL
+
+/**
+ * \brief           Insert timer in the slot matching its expiry
+ * \param[in]       wheel: Timer wheel
+ * \param[in]       timer: Timer with `expires` set
+ */
+static void
+prv_link(hsm_timer_wheel_t* wheel, hsm_timer_t* timer) {
+    uint32_t delta = timer->expires - wheel->now;
+    uint32_t when = timer->expires;
+    uint8_t level = 0;
+    hsm_timer_t** slot;
+
+    if (delta > PRV_RANGE) {
+        delta = PRV_RANGE;
+        when = wheel->now + PRV_RANGE;
+    }
+    while (level + 1 < HSM_CFG_TIMER_LEVELS && (delta >> (HSM_CFG_TIMER_BITS * (level + 1))) != 0) {
+        level++;
+    }
+
+    slot = &wheel->slots[level][(when >> (HSM_CFG_TIMER_BITS * level)) & PRV_MASK];
+    timer->next = *slot;
+    if (timer->next != NULL) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = slot;
+    *slot = timer;
+}
+
+/**
+ * \brief           Remove timer from its wheel slot
+ * \param[in]       timer: Armed timer
+ */
+static void
+prv_unlink(hsm_timer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->pprev = NULL;
+}
+
+/**
+ * \brief           Remove timer from the armed list of its instance
+ * \param[in]       timer: Armed timer
+ */
+static void
+prv_inst_unlink(hsm_timer_t* timer) {
+    *timer->inst_pprev = timer->inst_next;
+    if (timer->inst_next != NULL) {
+        timer->inst_next->inst_pprev = timer->inst_pprev;
+    }
+    timer->inst_pprev = NULL;
+}
+
+/**
+ * \brief           Detach slot list and return its first timer
+ * \param[in]       slot: Wheel slot
+ * \return          First timer of the detached list, or `NULL`
+ */
+static hsm_timer_t*
+prv_take(hsm_timer_t** slot) {
+    hsm_timer_t* list = *slot;
+
+    *slot = NULL;
+    return list;
+}
+
+/**
+ * \brief           Initialize timer wheel
+ * \param[in]       wheel: Timer wheel
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_timer_wheel_init(hsm_timer_wheel_t* wheel) {
+    if (wheel == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    for (uint8_t level = 0; level < HSM_CFG_TIMER_LEVELS; ++level) {
+        for (uint32_t i = 0; i < HSM_TIMER_SLOTS; ++i) {
+            wheel->slots[level][i] = NULL;
+        }
+    }
+    wheel->now = 0;
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Arm one-shot or periodic time event
+ *
+ * After `ticks` calls of \ref hsm_timer_tick, `event` is posted to `hsm`
+ * with `data`, then again every `period` ticks when `period` is not `0`.
+ * An armed timer is re-armed. When `state` is not `NULL`, the timer is
+ * cancelled once `state` is exited, typically the state arming it from
+ * its ENTRY handler.
+ *
+ * \param[in]       wheel: Timer wheel
+ * \param[in]       timer: Timer to arm
+ * \param[in]       hsm: Instance receiving the event, with queue initialized
+ * \param[in]       state: State cancelling the timer on EXIT, `NULL` for none
+ * \param[in]       event: Event to post
+ * \param[in]       data: Event data
+ * \param[in]       ticks: Delay, `1` up to `0x7FFFFFFF` ticks
+ * \param[in]       period: Re-arm interval in ticks, `0` for one-shot
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_timer_arm(hsm_timer_wheel_t* wheel, hsm_timer_t* timer, hsm_t* hsm, const hsm_state_t* state,
+              hsm_event_t event, void* data, uint32_t ticks, uint32_t period) {
+    if (wheel == NULL || timer == NULL || hsm == NULL || event == HSM_EVENT_NONE || ticks == 0
+        || ticks > PRV_MAX_TICKS || period > PRV_MAX_TICKS) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    HSM_CFG_TIMER_LOCK();
+    if (timer->pprev != NULL) {
+        prv_unlink(timer);
+        prv_inst_unlink(timer);
+    }
+    timer->hsm = hsm;
+    timer->state = state;
+    timer->event = event;
+    timer->data = data;
+    timer->period = period;
+    timer->expires = wheel->now + ticks;
+    prv_link(wheel, timer);
+
+    timer->inst_next = hsm->timers;
+    if (timer->inst_next != NULL) {
+        timer->inst_next->inst_pprev = &timer->inst_next;
+    }
+    timer->inst_pprev = &hsm->timers;
+    hsm->timers = timer;
+    HSM_CFG_TIMER_UNLOCK();
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Cancel time event
+ * \note            An expiry already posted stays in the instance queue
+ * \param[in]       timer: Timer to cancel, armed or not
+ * \return          \ref HSM_RES_OK on success
+ */
+hsm_result_t
+hsm_timer_cancel(hsm_timer_t* timer) {
+    if (timer == NULL) {
+        return HSM_RES_INVALID_PARAM;
+    }
+
+    HSM_CFG_TIMER_LOCK();
+    if (timer->pprev != NULL) {
+        prv_unlink(timer);
+        prv_inst_unlink(timer);
+    }
+    HSM_CFG_TIMER_UNLOCK();
+
+    return HSM_RES_OK;
+}
+
+/**
+ * \brief           Check if time event is armed
+ * \param[in]       timer: Timer to check
+ * \return          `1` if armed, `0` otherwise
+ */
+uint8_t
+hsm_timer_is_armed(const hsm_timer_t* timer) {
+    return timer != NULL && timer->pprev != NULL;
+}
+
+/**
+ * \brief           Advance timer wheel by one tick
+ *
+ * Call from the single tick source, e.g. a periodic hardware or OS timer.
+ * Expired timers post their event; a full queue drops that expiry.
+ *
+ * \param[in]       wheel: Timer wheel
+ * \return          Number of events posted
+ */
+uint32_t
+hsm_timer_tick(hsm_timer_wheel_t* wheel) {
+    hsm_timer_t *timer, *next;
+    uint32_t posted = 0;
+
+    if (wheel == NULL) {
+        return 0;
+    }
+
+    HSM_CFG_TIMER_LOCK();
+    wheel->now++;
+
+    /* Pull the next block of each level down once all lower levels wrapped */
+    for (uint8_t level = 1; level < HSM_CFG_TIMER_LEVELS; ++level) {
+        if (((wheel->now >> (HSM_CFG_TIMER_BITS * (level - 1))) & PRV_MASK) != 0) {
+            break;
+        }
+        timer = prv_take(&wheel->slots[level][(wheel->now >> (HSM_CFG_TIMER_BITS * level)) & PRV_MASK]);
+        for (; timer != NULL; timer = next) {
+            next = timer->next;
+            prv_link(wheel, timer);
+        }
+    }
+
+    /* Every timer of the current first level slot expires now */
+    timer = prv_take(&wheel->slots[0][wheel->now & PRV_MASK]);
+    for (; timer != NULL; timer = next) {
+        next = timer->next;
+        if ((int32_t)(timer->expires - wheel->now) > 0) {
+            /* Parked beyond wheel range, not due yet */
+            prv_link(wheel, timer);
+            continue;
+        }
+        if (hsm_post(timer->hsm, timer->event, timer->data) == HSM_RES_OK) {
+            posted++;
+        }
+        if (timer->period != 0) {
+            timer->expires = wheel->now + timer->period;
+            prv_link(wheel, timer);
+        } else {
+            timer->pprev = NULL;
+            prv_inst_unlink(timer);
+        }
+    }
+    HSM_CFG_TIMER_UNLOCK();
+
+    return posted;
+}
+
+/**
+ * \brief           Cancel timers bound to a state being exited
+ * \param[in]       hsm: Instance leaving the state
+ * \param[in]       state: Exited state
+ */
+void
+hsm_timer_exit_state(hsm_t* hsm, const hsm_state_t* state) {
+    hsm_timer_t *timer, *next;
+
+    HSM_CFG_TIMER_LOCK();
+    for (timer = hsm->timers; timer != NULL; timer = next) {
+        next = timer->inst_next;
+        if (timer->state == state) {
+            prv_unlink(timer);
+            prv_inst_unlink(timer);
+        }
+    }
+    HSM_CFG_TIMER_UNLOCK();
+}
+
+#endif /* HSM_CFG_TIMER */
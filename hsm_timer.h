@@ -0,0 +1,115 @@
+/**
+ * \file            hsm_timer.h
+ * \brief           Hierarchical timer wheel for HSM time events
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ * Version:         2.0.0
+ */
+#ifndef HSM_TIMER_HDR_H
+#define HSM_TIMER_HDR_H
+
+#include "hsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if HSM_CFG_TIMER
+
+/**
+ * \defgroup        HSM_TIMER Timer wheel
+ * \brief           One-shot and periodic time events posted to HSM queues
+ *
+ * One wheel serves any number of instances from a single tick source.
+ * Timers are kept in `HSM_CFG_TIMER_LEVELS` levels of `2^HSM_CFG_TIMER_BITS`
+ * slots each; arming and cancelling are O(1), a tick touches only the
+ * expiring slot and, every `2^HSM_CFG_TIMER_BITS` ticks, one slot of the
+ * next level.
+ *
+ * Expired timers post their event with \ref hsm_post; timers bound to a
+ * state are cancelled when that state is exited. Wheel functions must be
+ * serialised, either by calling them from one task or with
+ * `HSM_CFG_TIMER_LOCK` and `HSM_CFG_TIMER_UNLOCK`.
+ *
+ * \{
+ */
+
+/**
+ * \brief           Number of slots of one wheel level
+ */
+#define HSM_TIMER_SLOTS          (1UL << HSM_CFG_TIMER_BITS)
+
+/**
+ * \brief           Time event
+ *
+ * Application owned, zero-initialised or armed before any other use.
+ * Fields are private to the timer wheel.
+ */
+typedef struct hsm_timer {
+    struct hsm_timer* next;                   /*!< Next timer in wheel slot */
+    struct hsm_timer** pprev;                 /*!< Link pointing to this timer, `NULL` when idle */
+    struct hsm_timer* inst_next;              /*!< Next armed timer of the same instance */
+    struct hsm_timer** inst_pprev;            /*!< Instance link pointing to this timer */
+    hsm_t* hsm;                               /*!< Instance receiving the event */
+    const hsm_state_t* state;                 /*!< State cancelling the timer on EXIT, or `NULL` */
+    hsm_event_t event;                        /*!< Posted event */
+    void* data;                               /*!< Posted event data */
+    uint32_t expires;                         /*!< Expiry tick */
+    uint32_t period;                          /*!< Re-arm interval, `0` for one-shot */
+} hsm_timer_t;
+
+/**
+ * \brief           Timer wheel
+ */
+typedef struct hsm_timer_wheel {
+    hsm_timer_t* slots[HSM_CFG_TIMER_LEVELS][HSM_TIMER_SLOTS]; /*!< Timer lists per level and slot */
+    uint32_t now;                             /*!< Current tick */
+} hsm_timer_wheel_t;
+
+hsm_result_t hsm_timer_wheel_init(hsm_timer_wheel_t* wheel);
+hsm_result_t hsm_timer_arm(hsm_timer_wheel_t* wheel, hsm_timer_t* timer, hsm_t* hsm, const hsm_state_t* state,
+                           hsm_event_t event, void* data, uint32_t ticks, uint32_t period);
+hsm_result_t hsm_timer_cancel(hsm_timer_t* timer);
+uint8_t hsm_timer_is_armed(const hsm_timer_t* timer);
+uint32_t hsm_timer_tick(hsm_timer_wheel_t* wheel);
+
+/* Library internal, called by hsm.c when a state is exited */
+void hsm_timer_exit_state(hsm_t* hsm, const hsm_state_t* state);
+
+/**
+ * \}
+ */
+
+#endif /* HSM_CFG_TIMER */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HSM_TIMER_HDR_H */
@@ -0,0 +1,382 @@
+/**
+ * \file            hsm_analyse.c
+ * \brief           Offline checker for machine definitions
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+
+/*
+ * Reads a definition blob written by hsm_table_save(), or by
+ * hsm_table_save_states() for a pointer mode machine, checks it the way
+ * hsm_table_load() and hsm_table_check() do, and reports the cost of
+ * transitions for a given HSM_CFG_MAX_DEPTH.
+ *
+ * Build:   cc -std=c11 -o hsm_analyse hsm_analyse.c
+ * Usage:   hsm_analyse [-d max_depth] [-i initial] blob.bin [transitions.txt]
+ *
+ * The optional transitions file holds one "<from> <to>" pair of state
+ * indices per line, `#` starts a comment. With it, every listed
+ * transition is reported and, with -i, states not reachable from the
+ * initial state are listed. Without it, all state pairs are analysed.
+ *
+ * Exit code is 0 for a valid definition, 1 when a check failed, 2 on
+ * usage or input errors.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOB_HDR_SIZE 16
+#define BLOB_FLAG_LCA 0x01
+#define STATE_NONE    0xFF
+
+/**
+ * \brief           Loaded definition
+ */
+typedef struct {
+    uint8_t count;                            /*!< Number of states */
+    uint8_t handlers;                         /*!< Number of handlers referenced */
+    const uint8_t* states;                    /*!< `count` pairs of parent and handler index */
+    const uint8_t* lca;                       /*!< Optional `count * count` LCA table */
+    uint8_t depth[STATE_NONE];                /*!< Depth per state, 0 for roots */
+} machine_t;
+
+static uint8_t* blob;
+static size_t blob_len;
+
+/**
+ * \brief           Read little-endian 32-bit value
+ */
+static uint32_t
+get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * \brief           FNV-1a hash, same as the library
+ */
+static uint32_t
+fnv1a(const uint8_t* data, size_t len) {
+    uint32_t h = 0x811C9DC5UL;
+
+    while (len-- > 0) {
+        h = (h ^ *data++) * 0x01000193UL;
+    }
+    return h;
+}
+
+/**
+ * \brief           Read whole file
+ * \return          `1` on success, `0` on error
+ */
+static int
+load_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    long size;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        if (f != NULL) {
+            fclose(f);
+        }
+        return 0;
+    }
+    blob_len = (size_t)size;
+    blob = malloc(blob_len ? blob_len : 1);
+    if (blob == NULL || fread(blob, 1, blob_len, f) != blob_len) {
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    return 1;
+}
+
+/**
+ * \brief           Lowest common ancestor by parent walk
+ */
+static uint8_t
+lca_walk(const machine_t* m, uint8_t s1, uint8_t s2) {
+    while (s1 != STATE_NONE && s2 != STATE_NONE && m->depth[s1] > m->depth[s2]) {
+        s1 = m->states[2 * s1];
+    }
+    while (s1 != STATE_NONE && s2 != STATE_NONE && m->depth[s2] > m->depth[s1]) {
+        s2 = m->states[2 * s2];
+    }
+    while (s1 != s2) {
+        s1 = m->states[2 * s1];
+        s2 = m->states[2 * s2];
+    }
+    return s1;
+}
+
+/**
+ * \brief           Handler calls of one transition
+ * \param[out]      exits: Number of EXIT handlers
+ * \param[out]      entries: Number of ENTRY handlers
+ */
+static void
+path_length(const machine_t* m, uint8_t from, uint8_t to, unsigned* exits, unsigned* entries) {
+    uint8_t lca = lca_walk(m, from, to);
+    unsigned lca_depth = (lca == STATE_NONE) ? 0 : m->depth[lca] + 1u;
+
+    *exits = m->depth[from] + 1u - lca_depth;
+    *entries = m->depth[to] + 1u - lca_depth;
+}
+
+/**
+ * \brief           Check states, hierarchy and LCA table
+ * \param[in]       max_depth: `HSM_CFG_MAX_DEPTH` of the target build
+ * \return          Number of errors
+ */
+static unsigned
+check_machine(machine_t* m, unsigned max_depth) {
+    unsigned errors = 0;
+
+    for (unsigned i = 0; i < m->count; i++) {
+        unsigned levels = 1;
+        uint8_t parent = m->states[2 * i];
+
+        if (m->states[2 * i + 1] >= m->handlers) {
+            printf("error: state %u uses handler %u of %u\n", i, m->states[2 * i + 1], m->handlers);
+            errors++;
+        }
+        if (parent != STATE_NONE && parent >= m->count) {
+            printf("error: state %u has parent %u outside the table\n", i, parent);
+            errors++;
+            m->depth[i] = 0;
+            continue;
+        }
+        for (uint8_t s = parent; s != STATE_NONE && levels <= m->count; s = m->states[2 * s]) {
+            if (s >= m->count) {
+                break;
+            }
+            levels++;
+        }
+        if (levels > m->count) {
+            printf("error: state %u is part of a parent cycle\n", i);
+            errors++;
+            levels = 1;
+        } else if (levels > max_depth) {
+            printf("error: state %u is nested %u levels deep, HSM_CFG_MAX_DEPTH is %u\n", i, levels,
+                   max_depth);
+            errors++;
+        }
+        m->depth[i] = (uint8_t)(levels - 1);
+    }
+    if (errors > 0) {
+        return errors;
+    }
+
+    if (m->lca != NULL) {
+        for (unsigned i = 0; i < m->count; i++) {
+            for (unsigned j = 0; j < m->count; j++) {
+                if (m->lca[i * m->count + j] != lca_walk(m, (uint8_t)i, (uint8_t)j)) {
+                    printf("error: LCA table entry [%u][%u] does not match the hierarchy\n", i, j);
+                    errors++;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+/**
+ * \brief           Report one transition
+ */
+static void
+report_transition(const machine_t* m, uint8_t from, uint8_t to) {
+    unsigned exits, entries;
+
+    path_length(m, from, to, &exits, &entries);
+    printf("  %3u -> %3u  exits %2u  entries %2u  handler calls %2u  entry path %2u\n", from, to, exits,
+           entries, exits + entries, entries);
+}
+
+int
+main(int argc, char** argv) {
+    static machine_t m;
+    static uint8_t reach[STATE_NONE], edges[STATE_NONE][STATE_NONE];
+    unsigned max_depth = 8, worst = 0, worst_from = 0, worst_to = 0, errors, exits, entries;
+    unsigned max_entries = 0, max_level = 0;
+    int initial = -1, argi = 1, have_edges = 0;
+    size_t expected;
+
+    for (; argi < argc && argv[argi][0] == '-' && argi + 1 < argc; argi += 2) {
+        if (strcmp(argv[argi], "-d") == 0) {
+            max_depth = (unsigned)strtoul(argv[argi + 1], NULL, 0);
+        } else if (strcmp(argv[argi], "-i") == 0) {
+            initial = (int)strtol(argv[argi + 1], NULL, 0);
+        } else {
+            break;
+        }
+    }
+    if (argi >= argc || max_depth == 0) {
+        fprintf(stderr, "usage: %s [-d max_depth] [-i initial] blob.bin [transitions.txt]\n", argv[0]);
+        return 2;
+    }
+
+    if (!load_file(argv[argi])) {
+        fprintf(stderr, "cannot read %s\n", argv[argi]);
+        return 2;
+    }
+    if (blob_len < BLOB_HDR_SIZE || memcmp(blob, "HSMD", 4) != 0 || blob[4] != 1) {
+        fprintf(stderr, "%s: not an HSM definition blob\n", argv[argi]);
+        return 2;
+    }
+    m.count = blob[6];
+    m.handlers = blob[7];
+    expected = BLOB_HDR_SIZE + 2 * (size_t)m.count;
+    if (blob[5] & BLOB_FLAG_LCA) {
+        expected += (size_t)m.count * m.count;
+    }
+    if (m.count == 0 || m.count == STATE_NONE || get_u32(&blob[8]) != blob_len || blob_len != expected) {
+        fprintf(stderr, "%s: inconsistent size or state count\n", argv[argi]);
+        return 1;
+    }
+    if (get_u32(&blob[12]) != fnv1a(&blob[BLOB_HDR_SIZE], blob_len - BLOB_HDR_SIZE)) {
+        fprintf(stderr, "%s: hash mismatch, blob is corrupted\n", argv[argi]);
+        return 1;
+    }
+    m.states = &blob[BLOB_HDR_SIZE];
+    m.lca = (blob[5] & BLOB_FLAG_LCA) ? &blob[BLOB_HDR_SIZE + 2 * (size_t)m.count] : NULL;
+    if (initial >= m.count) {
+        fprintf(stderr, "initial state %d outside the table\n", initial);
+        return 2;
+    }
+
+    printf("%s: %u states, %u handlers, %s LCA table, checked for HSM_CFG_MAX_DEPTH %u\n", argv[argi],
+           m.count, m.handlers, m.lca != NULL ? "with" : "no", max_depth);
+    errors = check_machine(&m, max_depth);
+    if (errors > 0) {
+        printf("%u error(s)\n", errors);
+        return 1;
+    }
+
+    for (unsigned i = 0; i < m.count; i++) {
+        if (m.depth[i] + 1u > max_level) {
+            max_level = m.depth[i] + 1u;
+        }
+    }
+
+    /* Listed transitions, or every state pair */
+    if (argi + 1 < argc) {
+        char line[256];
+        FILE* f = fopen(argv[argi + 1], "r");
+
+        if (f == NULL) {
+            fprintf(stderr, "cannot open %s\n", argv[argi + 1]);
+            return 2;
+        }
+        have_edges = 1;
+        printf("transitions:\n");
+        while (fgets(line, sizeof(line), f) != NULL) {
+            unsigned from, to;
+            char* hash = strchr(line, '#');
+
+            if (hash != NULL) {
+                *hash = '\0';
+            }
+            if (sscanf(line, "%u %u", &from, &to) != 2) {
+                continue;
+            }
+            if (from >= m.count || to >= m.count) {
+                printf("error: transition %u -> %u outside the table\n", from, to);
+                errors++;
+                continue;
+            }
+            edges[from][to] = 1;
+            report_transition(&m, (uint8_t)from, (uint8_t)to);
+        }
+        fclose(f);
+    }
+    for (unsigned i = 0; i < m.count; i++) {
+        for (unsigned j = 0; j < m.count; j++) {
+            if (have_edges && !edges[i][j]) {
+                continue;
+            }
+            path_length(&m, (uint8_t)i, (uint8_t)j, &exits, &entries);
+            if (exits + entries > worst) {
+                worst = exits + entries;
+                worst_from = i;
+                worst_to = j;
+            }
+            if (entries > max_entries) {
+                max_entries = entries;
+            }
+        }
+    }
+
+    printf("deepest state:      %u levels\n", max_level);
+    printf("worst transition:   %u -> %u, %u handler calls\n", worst_from, worst_to, worst);
+    printf("entry path:         %u of %u slots (hsm_table_transition stack: %u bytes of path buffer)\n",
+           max_entries, max_depth, max_depth);
+    printf("pointer API paths:  %u bytes of exit and entry path buffers per transition\n",
+           2 * max_depth * (unsigned)sizeof(void*));
+
+    /* Reachability over listed transitions */
+    if (have_edges && initial >= 0) {
+        unsigned changed = 1, unreachable = 0;
+
+        reach[initial] = 1;
+        while (changed) {
+            changed = 0;
+            for (unsigned i = 0; i < m.count; i++) {
+                if (!reach[i]) {
+                    continue;
+                }
+                /* Ancestors are active with their substates, their transitions apply too */
+                for (uint8_t s = m.states[2 * i]; s != STATE_NONE; s = m.states[2 * s]) {
+                    if (!reach[s]) {
+                        reach[s] = 1;
+                        changed = 1;
+                    }
+                }
+                for (unsigned j = 0; j < m.count; j++) {
+                    if (edges[i][j] && !reach[j]) {
+                        reach[j] = 1;
+                        changed = 1;
+                    }
+                }
+            }
+        }
+        for (unsigned i = 0; i < m.count; i++) {
+            if (!reach[i]) {
+                printf("warning: state %u is not reachable from %d\n", i, initial);
+                unreachable++;
+            }
+        }
+        printf("unreachable states: %u\n", unreachable);
+    }
+
+    if (errors > 0) {
+        printf("%u error(s)\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,317 @@
+/**
+ * \file            hsm_bench.c
+ * \brief           HSM dispatch and transition benchmark
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+
+/*
+ * Measures the cost of hsm_dispatch() and hsm_transition() with the
+ * library configuration it is built with.
+ *
+ * Host:    built as `hsm_bench` by the top-level CMakeLists.txt, times
+ *          are in nanoseconds
+ * Target:  add this file to an application, call hsm_bench_run() (or
+ *          let the ESP-IDF `app_main()` below do it), times are in CPU
+ *          cycles
+ *
+ * Every sample times BENCH_BATCH operations and is divided by the batch
+ * size. BENCH_SAMPLES samples are sorted and reported as min, p50, p90
+ * and p99, in tenths of a unit per operation, so that one preemption
+ * or cache refill does not move the median.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include "hsm.h"
+#if HSM_CFG_TABLE
+#include "hsm_table.h"
+#endif /* HSM_CFG_TABLE */
+
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 101
+#endif
+
+#ifndef BENCH_BATCH
+#define BENCH_BATCH 64
+#endif
+
+#define BENCH_MAX_DEPTH 16
+#define BENCH_MAX_CHAIN 8
+
+/* Same timestamp source as the library tracing port, kept here since hsm_port.h is private */
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define BENCH_CYCLES()           ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#define BENCH_CYCLES()           ((uint32_t)esp_cpu_get_ccount())
+#endif
+#define BENCH_UNIT               "cycles"
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+/* DWT->CYCCNT, application must enable the DWT cycle counter */
+#define BENCH_CYCLES()           (*(volatile uint32_t*)0xE0001004UL)
+#define BENCH_UNIT               "cycles"
+#else
+#include <time.h>
+
+static inline uint32_t
+prv_bench_cycles(void) {
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define BENCH_CYCLES()           prv_bench_cycles()
+#define BENCH_UNIT               "ns"
+#endif
+
+#define EV_BENCH HSM_EVENT_USER
+
+/* Chains cannot be deeper than the library path buffers, root takes one level */
+#if HSM_CFG_MAX_DEPTH - 1 < BENCH_MAX_DEPTH
+#define BENCH_MAX_LCA (HSM_CFG_MAX_DEPTH - 1)
+#else
+#define BENCH_MAX_LCA BENCH_MAX_DEPTH
+#endif
+
+static uint32_t samples[BENCH_SAMPLES];
+static hsm_t bench_hsm;
+static hsm_state_t root, chain_a[BENCH_MAX_DEPTH], chain_b[BENCH_MAX_DEPTH];
+static hsm_state_t idle, links[BENCH_MAX_CHAIN + 1];
+static uint8_t chain_length;
+
+/**
+ * \brief           Handler consuming every user event
+ */
+static hsm_event_t
+prv_handled(hsm_t* hsm, hsm_event_t event, void* data) {
+    (void)hsm;
+    (void)data;
+    return event >= HSM_EVENT_USER ? HSM_EVENT_NONE : event;
+}
+
+/**
+ * \brief           Handler propagating every user event
+ */
+static hsm_event_t
+prv_pass(hsm_t* hsm, hsm_event_t event, void* data) {
+    (void)hsm;
+    (void)data;
+    return event >= HSM_EVENT_USER ? event : HSM_EVENT_NONE;
+}
+
+/**
+ * \brief           Handler of deferred chain states, ENTRY requests next link
+ *
+ * Transition parameter is the entered link, current state is only
+ * updated once the entry sequence is complete.
+ */
+static hsm_event_t
+prv_link(hsm_t* hsm, hsm_event_t event, void* data) {
+    if (event == HSM_EVENT_ENTRY && data != NULL) {
+        uint8_t i = (uint8_t)((hsm_state_t*)data - links);
+
+        if (i < chain_length) {
+            hsm_transition(hsm, &links[i + 1], &links[i + 1], NULL);
+        }
+    }
+    return HSM_EVENT_NONE;
+}
+
+/**
+ * \brief           Sort samples and print percentiles
+ * \param[in]       name: Measurement name
+ * \param[in]       arg: Measurement parameter, printed after the name
+ */
+static void
+prv_report(const char* name, uint32_t arg) {
+    uint32_t v;
+    int j;
+
+    /* Insertion sort, sample count is small */
+    for (int i = 1; i < BENCH_SAMPLES; ++i) {
+        v = samples[i];
+        for (j = i - 1; j >= 0 && samples[j] > v; --j) {
+            samples[j + 1] = samples[j];
+        }
+        samples[j + 1] = v;
+    }
+
+#define PRV_TENTHS(x) (unsigned)((x) / 10), (unsigned)((x) % 10)
+    printf("%-22s %3u  min %6u.%u  p50 %6u.%u  p90 %6u.%u  p99 %6u.%u\n", name, (unsigned)arg,
+           PRV_TENTHS(samples[0]), PRV_TENTHS(samples[BENCH_SAMPLES / 2]),
+           PRV_TENTHS(samples[BENCH_SAMPLES * 90 / 100]), PRV_TENTHS(samples[BENCH_SAMPLES * 99 / 100]));
+#undef PRV_TENTHS
+}
+
+/**
+ * \brief           Store one sample in tenths of a unit per operation
+ */
+static void
+prv_sample(int i, uint32_t start) {
+    samples[i] = (uint32_t)(((uint64_t)(uint32_t)(BENCH_CYCLES() - start) * 10) / BENCH_BATCH);
+}
+
+/**
+ * \brief           Build two chains of `depth` states below a common root
+ * \param[in]       depth: Chain length, 1 to \ref BENCH_MAX_DEPTH
+ * \param[in]       leaf: Handler of the chain leaves
+ * \param[in]       inner: Handler of inner chain states
+ * \param[in]       top: Handler of the root
+ */
+static void
+prv_build_chains(uint8_t depth, hsm_state_fn_t leaf, hsm_state_fn_t inner, hsm_state_fn_t top) {
+    hsm_state_create(&root, "ROOT", top, NULL);
+    for (uint8_t i = 0; i < depth; ++i) {
+        hsm_state_fn_t fn = (i + 1 == depth) ? leaf : inner;
+
+        hsm_state_create(&chain_a[i], "A", fn, i ? &chain_a[i - 1] : &root);
+        hsm_state_create(&chain_b[i], "B", fn, i ? &chain_b[i - 1] : &root);
+    }
+}
+
+/**
+ * \brief           Dispatch cost by depth, event handled by the leaf or by the root
+ */
+static void
+prv_bench_dispatch(void) {
+    uint32_t start;
+
+    for (int handled = 1; handled >= 0; --handled) {
+        for (uint8_t depth = 1; depth <= BENCH_MAX_LCA; ++depth) {
+            /* Root handles in fall-through case, `depth + 1` handlers run */
+            prv_build_chains(depth, handled ? prv_handled : prv_pass, prv_pass,
+                             handled ? prv_pass : prv_handled);
+            hsm_init(&bench_hsm, "BENCH", &chain_a[depth - 1]);
+
+            for (int i = 0; i < BENCH_SAMPLES; ++i) {
+                start = BENCH_CYCLES();
+                for (int n = 0; n < BENCH_BATCH; ++n) {
+                    hsm_dispatch(&bench_hsm, EV_BENCH, NULL);
+                }
+                prv_sample(i, start);
+            }
+            prv_report(handled ? "dispatch handled" : "dispatch fall-through", depth);
+        }
+    }
+}
+
+/**
+ * \brief           Transition cost by LCA distance, leaf to leaf across root
+ */
+static void
+prv_bench_transition(void) {
+    uint32_t start;
+
+    for (uint8_t depth = 1; depth <= BENCH_MAX_LCA; ++depth) {
+        prv_build_chains(depth, prv_handled, prv_handled, prv_handled);
+        hsm_init(&bench_hsm, "BENCH", &root);
+        hsm_transition(&bench_hsm, &chain_a[depth - 1], NULL, NULL);
+
+        /* Every transition exits and enters `depth` states */
+        for (int i = 0; i < BENCH_SAMPLES; ++i) {
+            start = BENCH_CYCLES();
+            for (int n = 0; n < BENCH_BATCH / 2; ++n) {
+                hsm_transition(&bench_hsm, &chain_b[depth - 1], NULL, NULL);
+                hsm_transition(&bench_hsm, &chain_a[depth - 1], NULL, NULL);
+            }
+            prv_sample(i, start);
+        }
+        prv_report("transition lca", depth);
+    }
+}
+
+/**
+ * \brief           Cost of transition chains requested from ENTRY handlers
+ */
+static void
+prv_bench_deferred(void) {
+    uint32_t start;
+
+    hsm_state_create(&idle, "IDLE", prv_handled, NULL);
+    for (uint8_t i = 0; i <= BENCH_MAX_CHAIN; ++i) {
+        hsm_state_create(&links[i], "LINK", prv_link, NULL);
+    }
+
+    /* Operation is one chain of `length + 1` transitions plus return to idle */
+    for (chain_length = 0; chain_length <= BENCH_MAX_CHAIN; ++chain_length) {
+        hsm_init(&bench_hsm, "BENCH", &idle);
+        for (int i = 0; i < BENCH_SAMPLES; ++i) {
+            start = BENCH_CYCLES();
+            for (int n = 0; n < BENCH_BATCH; ++n) {
+                hsm_transition(&bench_hsm, &links[0], &links[0], NULL);
+                hsm_transition(&bench_hsm, &idle, NULL, NULL);
+            }
+            prv_sample(i, start);
+        }
+        prv_report("deferred chain", chain_length);
+    }
+}
+
+/**
+ * \brief           Print structure sizes for the current configuration
+ */
+static void
+prv_bench_footprint(void) {
+    printf("sizeof(hsm_t)              %u\n", (unsigned)sizeof(hsm_t));
+    printf("sizeof(hsm_state_t)        %u\n", (unsigned)sizeof(hsm_state_t));
+#if HSM_CFG_TABLE
+    printf("sizeof(hsm_table_inst_t)   %u\n", (unsigned)sizeof(hsm_table_inst_t));
+    printf("sizeof(hsm_table_state_t)  %u\n", (unsigned)sizeof(hsm_table_state_t));
+#endif /* HSM_CFG_TABLE */
+}
+
+/**
+ * \brief           Run all measurements
+ */
+void
+hsm_bench_run(void) {
+    printf("hsm_bench: %u samples x %u operations, " BENCH_UNIT " per operation\n",
+           (unsigned)BENCH_SAMPLES, (unsigned)BENCH_BATCH);
+    printf("depth sweep 1 to %u, HSM_CFG_MAX_DEPTH %u\n", (unsigned)BENCH_MAX_LCA,
+           (unsigned)HSM_CFG_MAX_DEPTH);
+    prv_bench_footprint();
+    prv_bench_dispatch();
+    prv_bench_transition();
+    prv_bench_deferred();
+}
+
+#if defined(ESP_PLATFORM)
+void
+app_main(void) {
+    hsm_bench_run();
+}
+#elif !defined(HSM_BENCH_NO_MAIN)
+int
+main(void) {
+    hsm_bench_run();
+    return 0;
+}
+#endif
@@ -0,0 +1,279 @@
+/**
+ * \file            hsm_trace_decode.c
+ * \brief           Host decoder for HSM binary trace ring dumps
+ */
+
+/*
+ * Copyright (c) 2025 Pham Nam Hien
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of HSM library.
+ *
+ * Author:          Pham Nam Hien
+ */
+
+/*
+ * Reads the output of hsm_trace_ring_dump() and prints a timeline.
+ * Dumps are expected in little-endian byte order (ESP32, Cortex-M).
+ *
+ * Build:   cc -std=c11 -o hsm_trace_decode hsm_trace_decode.c
+ * Usage:   hsm_trace_decode dump.bin [events.txt]
+ *
+ * The optional events file holds one "<id> <name>" pair per line,
+ * ids can be decimal or 0x-prefixed hexadecimal.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENT_NAMES 1024
+#define ID_NONE         0xFFFF
+
+/**
+ * \brief           Trace point names, in `hsm_trace_type_t` order
+ */
+static const char* const type_names[] = {
+    "DISPATCH>", "DISPATCH<", "HANDLER", "EXIT", "ENTRY", "TRANS>", "TRANS<", "DEFERRED", "TRANS!",
+};
+
+/**
+ * \brief           Name table loaded from dump
+ */
+typedef struct {
+    char** names;
+    uint16_t count;
+} name_table_t;
+
+static struct {
+    uint32_t id;
+    char* name;
+} event_names[MAX_EVENT_NAMES];
+static size_t event_name_count;
+
+/**
+ * \brief           Read little-endian unsigned value
+ * \param[in]       f: Input file
+ * \param[in]       size: Value size in bytes, up to 4
+ * \param[out]      value: Decoded value
+ * \return          `1` on success, `0` on end of file
+ */
+static int
+read_le(FILE* f, size_t size, uint32_t* value) {
+    uint8_t b[4];
+    size_t i;
+
+    if (fread(b, 1, size, f) != size) {
+        return 0;
+    }
+    *value = 0;
+    for (i = 0; i < size; i++) {
+        *value |= (uint32_t)b[i] << (8 * i);
+    }
+    return 1;
+}
+
+/**
+ * \brief           Read length-prefixed name table
+ * \param[in]       f: Input file
+ * \param[out]      table: Table to fill
+ * \param[in]       count: Number of names
+ * \return          `1` on success, `0` on error
+ */
+static int
+read_names(FILE* f, name_table_t* table, uint16_t count) {
+    uint32_t len;
+    uint16_t i;
+
+    table->count = count;
+    table->names = calloc(count ? count : 1, sizeof(char*));
+    if (table->names == NULL) {
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        if (!read_le(f, 2, &len) || (table->names[i] = malloc(len + 1)) == NULL) {
+            return 0;
+        }
+        if (fread(table->names[i], 1, len, f) != len) {
+            return 0;
+        }
+        table->names[i][len] = '\0';
+    }
+    return 1;
+}
+
+/**
+ * \brief           Free name table, also when partially read
+ * \param[in]       table: Table to free
+ */
+static void
+free_names(name_table_t* table) {
+    uint16_t i;
+
+    for (i = 0; table->names != NULL && i < table->count; i++) {
+        free(table->names[i]);
+    }
+    free(table->names);
+    table->names = NULL;
+    table->count = 0;
+}
+
+/**
+ * \brief           Load optional event name file
+ * \param[in]       path: File path
+ */
+static void
+load_event_names(const char* path) {
+    char line[256], name[200];
+    FILE* f = fopen(path, "r");
+
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return;
+    }
+    while (event_name_count < MAX_EVENT_NAMES && fgets(line, sizeof(line), f) != NULL) {
+        char* end;
+        unsigned long id = strtoul(line, &end, 0);
+
+        if (end != line && sscanf(end, "%199s", name) == 1) {
+            event_names[event_name_count].id = (uint32_t)id;
+            event_names[event_name_count].name = malloc(strlen(name) + 1);
+            if (event_names[event_name_count].name != NULL) {
+                strcpy(event_names[event_name_count].name, name);
+                event_name_count++;
+            }
+        }
+    }
+    fclose(f);
+}
+
+/**
+ * \brief           Format event for output
+ * \param[in]       event: Event id
+ * \param[out]      buf: Output buffer
+ * \param[in]       size: Output buffer size
+ */
+static void
+format_event(uint32_t event, char* buf, size_t size) {
+    size_t i;
+
+    switch (event) {
+        case 0x00: snprintf(buf, size, "-"); return;
+        case 0x01: snprintf(buf, size, "ENTRY"); return;
+        case 0x02: snprintf(buf, size, "EXIT"); return;
+        default: break;
+    }
+    for (i = 0; i < event_name_count; i++) {
+        if (event_names[i].id == event) {
+            snprintf(buf, size, "%s", event_names[i].name);
+            return;
+        }
+    }
+    if (event >= 0x10) {
+        snprintf(buf, size, "USER+%lu", (unsigned long)(event - 0x10));
+    } else {
+        snprintf(buf, size, "0x%02lX", (unsigned long)event);
+    }
+}
+
+/**
+ * \brief           Format table name for output
+ * \param[in]       table: Name table
+ * \param[in]       id: Id to look up
+ * \param[out]      buf: Output buffer
+ * \param[in]       size: Output buffer size
+ */
+static void
+format_name(const name_table_t* table, uint32_t id, char* buf, size_t size) {
+    if (id == ID_NONE) {
+        snprintf(buf, size, "-");
+    } else if (id < table->count && table->names[id][0] != '\0') {
+        snprintf(buf, size, "%s", table->names[id]);
+    } else {
+        snprintf(buf, size, "#%lu", (unsigned long)id);
+    }
+}
+
+int
+main(int argc, char** argv) {
+    uint32_t version, record_size, state_count, hsm_count, records;
+    uint32_t i, ts, prev_ts = 0, event, state, hsm, type;
+    name_table_t states = {NULL, 0}, hsms = {NULL, 0};
+    char magic[4], hsm_buf[64], state_buf[64], event_buf[64];
+    int ret = 1;
+    FILE* f;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s dump.bin [events.txt]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 2) {
+        load_event_names(argv[2]);
+    }
+
+    f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "HSMT", 4) != 0 || !read_le(f, 2, &version)
+        || !read_le(f, 2, &record_size) || !read_le(f, 2, &state_count) || !read_le(f, 2, &hsm_count)
+        || !read_le(f, 4, &records)) {
+        fprintf(stderr, "%s: not an HSM trace dump\n", argv[1]);
+        goto out;
+    }
+    if (version != 1 || record_size != 12) {
+        fprintf(stderr, "%s: unsupported dump version %lu\n", argv[1], (unsigned long)version);
+        goto out;
+    }
+    if (!read_names(f, &states, (uint16_t)state_count) || !read_names(f, &hsms, (uint16_t)hsm_count)) {
+        fprintf(stderr, "%s: truncated name table\n", argv[1]);
+        goto out;
+    }
+
+    printf("%10s %10s  %-16s %-10s %-20s %s\n", "timestamp", "delta", "hsm", "type", "state", "event");
+    for (i = 0; i < records; i++) {
+        if (!read_le(f, 4, &ts) || !read_le(f, 4, &event) || !read_le(f, 2, &state) || !read_le(f, 1, &hsm)
+            || !read_le(f, 1, &type)) {
+            fprintf(stderr, "%s: truncated after %lu records\n", argv[1], (unsigned long)i);
+            break;
+        }
+        format_name(&hsms, hsm == 0xFF ? ID_NONE : hsm, hsm_buf, sizeof(hsm_buf));
+        format_name(&states, state, state_buf, sizeof(state_buf));
+        format_event(event, event_buf, sizeof(event_buf));
+        printf("%10lu %10lu  %-16s %-10s %-20s %s\n", (unsigned long)ts,
+               (unsigned long)(i == 0 ? 0 : ts - prev_ts), hsm_buf,
+               type < sizeof(type_names) / sizeof(type_names[0]) ? type_names[type] : "?", state_buf,
+               event_buf);
+        prev_ts = ts;
+    }
+    ret = 0;
+
+out:
+    free_names(&states);
+    free_names(&hsms);
+    for (i = 0; i < event_name_count; i++) {
+        free(event_names[i].name);
+    }
+    fclose(f);
+    return ret;
+}